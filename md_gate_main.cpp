@@ -1,19 +1,27 @@
 #include "marketdata_payload.h"
+#include "feed_gap_tracker.h"
+#include "l3_book_builder.h"
+#include "limit_up_tracker.h"
+#include "seal_erosion_tracker.h"
+#include "live_trade_overlay.h"
 #include "shm_writer.h"
+#include "snapshot_coalescer.h"
 
 #include <algorithm>
 #include <atomic>
 #include <cctype>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
 #include <sstream>
 #include <string>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
 #if defined(_WIN32)
@@ -94,24 +102,14 @@ static void SleepMs(uint32_t ms) {
 #endif
 }
 
-static inline void CpuRelax() {
-#if defined(_MSC_VER)
-  YieldProcessor();
-#elif defined(__i386__) || defined(__x86_64__)
-  __asm__ __volatile__("pause" ::: "memory");
-#else
-  // no-op
-#endif
-}
-
 static inline void LockSpin(volatile long* p) {
 #if defined(_WIN32)
   while (InterlockedExchange(p, 1) != 0) {
-    CpuRelax();
+    cpu_relax();
   }
 #else
   while (__sync_lock_test_and_set(p, 1) != 0) {
-    CpuRelax();
+    cpu_relax();
   }
 #endif
 }
@@ -314,6 +312,71 @@ static bool ParseCsvSymbols(const std::string& csv_path, std::vector<std::string
   return true;
 }
 
+// Update-count stats file ("wind_code,update_count" per line after a header), written on shutdown
+// from SnapshotEntry::update_count and read back by the next run's layout pass.
+static bool LoadUpdateStats(const std::string& path, std::map<std::string, uint64_t>* out) {
+  out->clear();
+  std::ifstream file(path.c_str());
+  if (!file.is_open()) return false;
+  std::string line;
+  bool header = true;
+  while (std::getline(file, line)) {
+    if (header) {
+      header = false;
+      continue;
+    }
+    const size_t comma = line.find(',');
+    if (comma == std::string::npos) continue;
+    const std::string code = Trim(line.substr(0, comma));
+    if (code.empty()) continue;
+    (*out)[code] = std::strtoull(line.c_str() + comma + 1, nullptr, 10);
+  }
+  return true;
+}
+
+static bool SaveUpdateStats(const std::string& path, const std::vector<std::string>& wind_codes,
+                            const SnapshotEntry* entries) {
+  const std::string tmp = path + ".tmp";
+  {
+    std::ofstream file(tmp.c_str(), std::ios::trunc);
+    if (!file.is_open()) return false;
+    file << "wind_code,update_count\n";
+    for (size_t i = 0; i < wind_codes.size(); ++i) {
+      file << wind_codes[i] << ',' << entries[i].update_count << '\n';
+    }
+    if (!file.good()) return false;
+  }
+  std::remove(path.c_str());
+  return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+// Id layout pass: hot symbols get adjacent low ids so the writer and basket readers touch fewer
+// pages/lines. Order: members of any reader basket first, then previous-run update count (desc);
+// ties keep CSV order. symbol_dir (written from the result) stays the id authority for readers.
+static void ApplyFrequencyLayout(const std::map<std::string, uint64_t>& counts, const std::set<std::string>& basket,
+                                 std::vector<std::string>* wind_codes) {
+  struct Ranked {
+    bool in_basket;
+    uint64_t count;
+    size_t csv_pos;
+  };
+  std::vector<Ranked> rank(wind_codes->size());
+  for (size_t i = 0; i < wind_codes->size(); ++i) {
+    const std::map<std::string, uint64_t>::const_iterator it = counts.find((*wind_codes)[i]);
+    rank[i].in_basket = basket.count((*wind_codes)[i]) != 0;
+    rank[i].count = (it != counts.end()) ? it->second : 0;
+    rank[i].csv_pos = i;
+  }
+  std::stable_sort(rank.begin(), rank.end(), [](const Ranked& a, const Ranked& b) {
+    if (a.in_basket != b.in_basket) return a.in_basket;
+    return a.count > b.count;
+  });
+  std::vector<std::string> ordered;
+  ordered.reserve(rank.size());
+  for (size_t i = 0; i < rank.size(); ++i) ordered.push_back((*wind_codes)[rank[i].csv_pos]);
+  wind_codes->swap(ordered);
+}
+
 static std::string JoinSubscriptions(const std::vector<std::string>& wind_codes) {
   std::string out;
   for (size_t i = 0; i < wind_codes.size(); ++i) {
@@ -329,50 +392,6 @@ static std::string ExtractNumericCode(const std::string& wind_code) {
   return wind_code.substr(0, pos);
 }
 
-static bool ParseWindCodeKey(const char* wind_code, uint32_t* out_key, char out_wind16[16]) {
-  if (!wind_code || !out_key || !out_wind16) return false;
-
-  // Bounded parse: accept "600000.SH" / "000001.SZ" (min 9 chars).
-  // We only accept exactly 6 digits, then '.', then 'S' + {'H'|'Z'}.
-  char digits[6];
-  for (int i = 0; i < 6; ++i) {
-    const char c = wind_code[i];
-    if (c < '0' || c > '9') return false;
-    digits[i] = c;
-  }
-  if (wind_code[6] != '.') return false;
-  char m0 = wind_code[7];
-  char m1 = wind_code[8];
-  m0 = static_cast<char>(std::toupper(static_cast<unsigned char>(m0)));
-  m1 = static_cast<char>(std::toupper(static_cast<unsigned char>(m1)));
-  if (m0 != 'S') return false;
-
-  uint32_t market = 0;
-  if (m1 == 'H') market = 1;
-  else if (m1 == 'Z') market = 0;
-  else return false;
-
-  uint32_t code = 0;
-  for (int i = 0; i < 6; ++i) {
-    code = code * 10u + static_cast<uint32_t>(digits[i] - '0');
-  }
-
-  *out_key = market * 1000000u + code;
-
-  std::memset(out_wind16, 0, 16);
-  out_wind16[0] = digits[0];
-  out_wind16[1] = digits[1];
-  out_wind16[2] = digits[2];
-  out_wind16[3] = digits[3];
-  out_wind16[4] = digits[4];
-  out_wind16[5] = digits[5];
-  out_wind16[6] = '.';
-  out_wind16[7] = 'S';
-  out_wind16[8] = (market == 1) ? 'H' : 'Z';
-  out_wind16[9] = '\0';
-  return true;
-}
-
 static bool ContainsSTToken(const char* raw, size_t len) {
   if (!raw) return false;
   std::string buffer;
@@ -497,6 +516,16 @@ struct Options {
   bool unlink_on_exit = false;
   uint32_t mock_interval_ms = 1000;  // 模拟行情间隔（毫秒）
   bool replay_mode = false;     // 历史回放模式：nTime=0xFFFFFFFF，用于测试服务器回放历史行情
+  std::string update_stats_path;  // per-symbol update counts: loaded for the layout pass, rewritten on exit
+  bool layout_by_frequency = false;  // assign symbol_ids hot-first (see ApplyFrequencyLayout)
+  std::string basket_csvs;      // comma-separated reader basket CSVs, placed first by the layout pass
+  bool coalesce = false;        // stage updates per symbol (last value wins) and publish from a separate thread
+  uint32_t txn_ring_capacity = kDefaultTransactionRingCapacity;  // transaction ring slots (with TRANSACTION)
+  uint32_t order_ring_capacity = kDefaultOrderRingCapacity;      // order ring slots (with ORDER)
+  std::string index_codes;      // comma-separated index codes (e.g. 000001.SH,399001.SZ) for the index table
+  bool l3_book = false;         // rebuild SZ stock books from orders + trades (needs type_flags ORDER|TRANSACTION)
+  uint32_t l3_max_orders = kDefaultL3MaxOrders;  // resting order pool of the L3 book builder
+  uint32_t history_depth = kDefaultHistoryDepth;  // snapshots kept per symbol in SHM (0 = no history)
 };
 
 static void PrintUsage(const char* argv0) {
@@ -516,7 +545,17 @@ static void PrintUsage(const char* argv0) {
       << "  --unlink-on-exit\n"
       << "  --mock                (mock mode: generate fake market data without TDF connection)\n"
       << "  --mock-interval <ms>  (mock data interval in milliseconds, default 1000)\n"
-      << "  --replay              (historical replay mode: nTime=0xFFFFFFFF for test server)\n";
+      << "  --replay              (historical replay mode: nTime=0xFFFFFFFF for test server)\n"
+      << "  --update-stats <path> (per-symbol update counts: read at start, rewritten on exit)\n"
+      << "  --layout-by-frequency (assign symbol_ids hot-first from --update-stats and --baskets)\n"
+      << "  --baskets <a.csv,b.csv> (reader basket CSVs placed first by the layout pass)\n"
+      << "  --coalesce            (per-symbol last-value-wins staging + publisher thread, for bursts)\n"
+      << "  --txn-ring-capacity <n> (transaction ring slots, power of two; default 1048576 = 64MB)\n"
+      << "  --order-ring-capacity <n> (order ring slots, power of two; default 2097152 = 128MB)\n"
+      << "  --indices <a.SH,b.SZ> (subscribe index codes and publish them in the SHM index table)\n"
+      << "  --l3-book             (rebuild SZ stock books from orders + trades; needs --type-flags 6)\n"
+      << "  --l3-max-orders <n>   (resting order pool of --l3-book; default 4194304)\n"
+      << "  --history-depth <n>   (snapshots kept per symbol, power of two; default 256, 0=off)\n";
 }
 
 static bool ApplyConfigJson(const std::string& path, Options* opt) {
@@ -535,6 +574,26 @@ static bool ApplyConfigJson(const std::string& path, Options* opt) {
     // 0 = snapshot only, 2=TRANSACTION, 4=ORDER, 8=ORDERQUEUE, combine with '|'.
     if (JsonGetInt(market_obj, "type_flags", &iv) && iv >= 0) opt->type_flags = static_cast<uint32_t>(iv);
     if (JsonGetInt(market_obj, "nTypeFlags", &iv) && iv >= 0) opt->type_flags = static_cast<uint32_t>(iv);
+    if (JsonGetInt(market_obj, "coalesce", &iv)) opt->coalesce = (iv != 0);
+    if (JsonGetInt(market_obj, "txn_ring_capacity", &iv) && iv > 0) {
+      opt->txn_ring_capacity = static_cast<uint32_t>(iv);
+    }
+    if (JsonGetInt(market_obj, "order_ring_capacity", &iv) && iv > 0) {
+      opt->order_ring_capacity = static_cast<uint32_t>(iv);
+    }
+    if (JsonGetString(market_obj, "index_codes", &v) && !v.empty()) opt->index_codes = v;
+    if (JsonGetInt(market_obj, "l3_book", &iv)) opt->l3_book = (iv != 0);
+    if (JsonGetInt(market_obj, "l3_max_orders", &iv) && iv > 0) opt->l3_max_orders = static_cast<uint32_t>(iv);
+    if (JsonGetInt(market_obj, "history_depth", &iv) && iv >= 0) opt->history_depth = static_cast<uint32_t>(iv);
+  }
+
+  std::string layout_obj;
+  if (ExtractJsonObject(txt, "layout", &layout_obj)) {
+    std::string v;
+    int iv = 0;
+    if (JsonGetString(layout_obj, "update_stats_path", &v) && !v.empty()) opt->update_stats_path = v;
+    if (JsonGetInt(layout_obj, "by_frequency", &iv)) opt->layout_by_frequency = (iv != 0);
+    if (JsonGetString(layout_obj, "basket_csvs", &v) && !v.empty()) opt->basket_csvs = v;
   }
 
   std::string strategy_obj;
@@ -671,6 +730,40 @@ static bool ParseArgs(int argc, char** argv, Options* opt) {
       opt->mock_interval_ms = static_cast<uint32_t>(std::atoi(v));
     } else if (a == "--replay") {
       opt->replay_mode = true;
+    } else if (a == "--update-stats") {
+      const char* v = need("--update-stats");
+      if (!v) return false;
+      opt->update_stats_path = v;
+    } else if (a == "--coalesce") {
+      opt->coalesce = true;
+    } else if (a == "--txn-ring-capacity") {
+      const char* v = need("--txn-ring-capacity");
+      if (!v) return false;
+      opt->txn_ring_capacity = static_cast<uint32_t>(std::strtoul(v, nullptr, 10));
+    } else if (a == "--order-ring-capacity") {
+      const char* v = need("--order-ring-capacity");
+      if (!v) return false;
+      opt->order_ring_capacity = static_cast<uint32_t>(std::strtoul(v, nullptr, 10));
+    } else if (a == "--indices") {
+      const char* v = need("--indices");
+      if (!v) return false;
+      opt->index_codes = v;
+    } else if (a == "--l3-book") {
+      opt->l3_book = true;
+    } else if (a == "--l3-max-orders") {
+      const char* v = need("--l3-max-orders");
+      if (!v) return false;
+      opt->l3_max_orders = static_cast<uint32_t>(std::strtoul(v, nullptr, 10));
+    } else if (a == "--history-depth") {
+      const char* v = need("--history-depth");
+      if (!v) return false;
+      opt->history_depth = static_cast<uint32_t>(std::strtoul(v, nullptr, 10));
+    } else if (a == "--layout-by-frequency") {
+      opt->layout_by_frequency = true;
+    } else if (a == "--baskets") {
+      const char* v = need("--baskets");
+      if (!v) return false;
+      opt->basket_csvs = v;
     } else if (a == "-h" || a == "--help") {
       PrintUsage(argv[0]);
       return false;
@@ -712,17 +805,7 @@ public:
                 << " exceeds symbol_count=" << opt_.symbol_count << std::endl;
       return false;
     }
-
-    codekey2id_.clear();
-    codekey2id_.reserve(wind_codes_.size() * 2 + 1);
-    for (size_t i = 0; i < wind_codes_.size(); ++i) {
-      uint32_t key = 0;
-      char canon[16];
-      if (!ParseWindCodeKey(wind_codes_[i].c_str(), &key, canon)) {
-        continue;
-      }
-      codekey2id_[key] = static_cast<uint32_t>(i);
-    }
+    if (opt_.layout_by_frequency) ApplyLayout();
 
     // Per-symbol writer locks (0=unlocked, 1=locked). Used only inside md_gate process.
     entry_locks_.assign(opt_.symbol_count, 0L);
@@ -731,20 +814,93 @@ public:
     std::cout << "[md_gate] csv=" << opt_.csv_path << " symbols=" << wind_codes_.size() << std::endl;
     std::cout << "[md_gate] shm=" << opt_.shm_name << " symbol_count=" << opt_.symbol_count << std::endl;
 
-    if (!writer_.Create(opt_.shm_name.c_str(), opt_.symbol_count)) {
+    // Event rings and the order queue table only exist for the subscribed tick-by-tick types.
+    ShmCreateOptions shm_opts;
+    if (opt_.type_flags & DATA_TYPE_TRANSACTION) shm_opts.transaction_ring_capacity = opt_.txn_ring_capacity;
+    if (opt_.type_flags & DATA_TYPE_ORDER) shm_opts.order_ring_capacity = opt_.order_ring_capacity;
+    shm_opts.order_queue_table = (opt_.type_flags & DATA_TYPE_ORDERQUEUE) != 0;
+    shm_opts.index_table = !opt_.index_codes.empty();
+    shm_opts.live_trade_table = (opt_.type_flags & DATA_TYPE_TRANSACTION) != 0;
+    shm_opts.history_depth = opt_.history_depth;
+    shm_opts.limit_up_table = true;
+    shm_opts.seal_erosion_table = true;
+    if (opt_.l3_book) {
+      const uint32_t need = DATA_TYPE_ORDER | DATA_TYPE_TRANSACTION;
+      if ((opt_.type_flags & need) == need) {
+        shm_opts.l3_book_table = true;
+      } else {
+        std::cerr << "[md_gate] --l3-book needs type_flags ORDER|TRANSACTION, disabled" << std::endl;
+      }
+    }
+
+    if (!writer_.Create(opt_.shm_name.c_str(), opt_.symbol_count, shm_opts)) {
       std::cerr << "[md_gate] shm create failed errno=" << writer_.last_errno() << std::endl;
       return false;
     }
 
-    // Publish id -> wind_code directory into SHM (symbol_dir).
+    // Publish id -> wind_code directory into SHM (symbol_dir + symbol index).
     // This allows trade processes to use their own smaller CSV subsets while still locating the correct slot.
+    // The gateway itself resolves incoming wind codes through the same SHM index (LookupSymbolId).
     for (size_t i = 0; i < wind_codes_.size(); ++i) {
       writer_.WriteSymbolDirEntry(static_cast<uint32_t>(i), wind_codes_[i].c_str());
     }
 
+    // Index table: ids in --indices order; the codes are added to the TDF subscription.
+    if (shm_opts.index_table) {
+      std::stringstream ss(opt_.index_codes);
+      std::string code;
+      uint32_t indices = 0;
+      while (std::getline(ss, code, ',')) {
+        code = Trim(code);
+        if (code.empty()) continue;
+        if (writer_.AddIndex(code.c_str()) == kInvalidSymbolId) {
+          std::cerr << "[md_gate] skip index code: " << code << std::endl;
+          continue;
+        }
+        subscriptions_ += (subscriptions_.empty() ? "" : ";") + code;
+        ++indices;
+      }
+      std::cout << "[md_gate] index table: " << indices << " index code(s)" << std::endl;
+    }
+
+    gaps_.Init(&writer_, writer_.header()->symbol_count);
+    staged_.reserve(writer_.header()->symbol_count);
+    if (writer_.live_trades()) live_.Init(&writer_, writer_.header()->symbol_count);
+    if (writer_.limit_ups()) limit_up_.Init(&writer_, writer_.header()->symbol_count);
+    if (writer_.l3_books()) {
+      l3_.Init(&writer_, writer_.header()->symbol_count, opt_.l3_max_orders);
+      std::cout << "[md_gate] l3 book: SZ stocks, order pool=" << opt_.l3_max_orders << std::endl;
+    }
+    if (writer_.seal_erosions() && limit_up_.enabled()) {
+      erosion_.Init(&writer_, writer_.header()->symbol_count, &limit_up_);
+      // SH cancels are order records carrying their price; SZ cancels carry none and are only priced
+      // through the L3 book, so cancelled[] is fed per market.
+      for (size_t i = 0; i < wind_codes_.size(); ++i) {
+        uint32_t key = 0;
+        if (!parse_wind_code_key(wind_codes_[i].c_str(), &key, nullptr)) continue;
+        uint32_t feed = 0;
+        if (opt_.type_flags & DATA_TYPE_TRANSACTION) feed |= kSealErosionTrades;
+        const bool sh = key / 1000000u == 1;
+        if (sh ? (opt_.type_flags & DATA_TYPE_ORDER) != 0 : (l3_.enabled() && IsL3BookKey(key))) {
+          feed |= kSealErosionCancels;
+        }
+        erosion_.SetFeedFlags(static_cast<uint32_t>(i), feed);
+      }
+    }
+    if (writer_.has_history()) {
+      std::cout << "[md_gate] snapshot history: " << writer_.header()->history_depth << " per symbol" << std::endl;
+    }
+
     // Mark as (re)connecting until login success.
     writer_.SetMdStatus(2);
     writer_.SetLastErr(0);
+
+    if (opt_.coalesce) {
+      coalescer_.Init(opt_.symbol_count);
+      publishing_.store(true, std::memory_order_release);
+      publisher_ = std::thread(&MdGateApp::PublishLoop, this);
+      std::cout << "[md_gate] coalesce mode: publisher thread started" << std::endl;
+    }
     return true;
   }
 
@@ -818,6 +974,18 @@ public:
     while (!StopRequested()) {
       const uint64_t now = NowMonotonicNs();
       writer_.UpdateHeartbeat(now);
+
+      // Reader registry: reclaim dead pids and publish aggregate lag.
+      const uint32_t reclaimed = writer_.ScanReaders();
+      if (reclaimed != 0) {
+        std::cout << "[md_gate] reclaimed " << reclaimed << " reader slot(s) from dead pids, active="
+                  << load_u32_relaxed(&writer_.header()->reader_active) << std::endl;
+      }
+      // Per-reader mirrors: pick up new/changed interest sets.
+      if (writer_.ScanMirrors() != 0) {
+        std::cout << "[md_gate] mirrors updated, active="
+                  << load_u32_relaxed(&writer_.header()->mirror_active) << std::endl;
+      }
       SleepMs(opt_.heartbeat_ms);
     }
   }
@@ -838,6 +1006,18 @@ public:
     }
     connected_ = false;
 
+    // Callbacks are done: let the publisher flush what is still pending, then stop it.
+    if (publisher_.joinable()) {
+      publishing_.store(false, std::memory_order_release);
+      publisher_.join();
+    }
+
+    if (!opt_.update_stats_path.empty() && writer_.entries()) {
+      if (!SaveUpdateStats(opt_.update_stats_path, wind_codes_, writer_.entries())) {
+        std::cerr << "[md_gate] failed to write update stats: " << opt_.update_stats_path << std::endl;
+      }
+    }
+
     if (opt_.unlink_on_exit) {
       writer_.Unlink(opt_.shm_name.c_str());
     }
@@ -845,6 +1025,74 @@ public:
   }
 
 private:
+  // Coalesce mode: the only SHM snapshot writer. One drained batch = one publish generation.
+  void PublishLoop() {
+    std::vector<uint32_t> ids(coalescer_.symbol_count());
+    std::vector<MarketData320> batch_md(ids.size());
+    std::vector<uint64_t> batch_ns(ids.size());
+    uint32_t idle = 0;
+    for (;;) {
+      const bool live = publishing_.load(std::memory_order_acquire);
+      const size_t n = coalescer_.Drain(ids.data(), ids.size());
+      if (n != 0) {
+        idle = 0;
+        PublishBatch(ids.data(), n, batch_md.data(), batch_ns.data());
+        continue;
+      }
+      if (!live) break;  // stopped and fully drained
+      // Idle backoff: stay hot through short gaps between messages, then stop burning the core.
+      if (++idle < 1024) {
+        cpu_relax();
+      } else if (idle < 2048) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+    }
+  }
+
+  // batch_md / batch_ns hold n entries: everything is taken out of the coalescer before the bracket
+  // opens, so it only covers the SHM writes.
+  void PublishBatch(const uint32_t* ids, size_t n, MarketData320* batch_md, uint64_t* batch_ns) {
+    uint64_t last_ns = 0;
+    for (size_t i = 0; i < n; ++i) {
+      const uint32_t symbol_id = ids[i];
+      LockSpin(&entry_locks_[symbol_id]);
+      coalescer_.Take(symbol_id, &batch_md[i], &batch_ns[i]);
+      UnlockSpin(&entry_locks_[symbol_id]);
+      if (batch_ns[i] > last_ns) last_ns = batch_ns[i];
+    }
+    writer_.BeginPublish();
+    for (size_t i = 0; i < n; ++i) writer_.UpdateSnapshot(ids[i], batch_md[i], batch_ns[i]);
+    writer_.EndPublish();
+
+    ShmHeader* h = writer_.header();
+    store_u64_release(&h->last_md_ns, last_ns);
+    store_u64_relaxed(&h->coalesced_updates, coalescer_.coalesced());
+    store_u32_relaxed(&h->pending_depth, coalescer_.depth());
+  }
+
+  void ApplyLayout() {
+    std::map<std::string, uint64_t> counts;
+    if (!opt_.update_stats_path.empty() && !LoadUpdateStats(opt_.update_stats_path, &counts)) {
+      std::cout << "[md_gate] no update stats at " << opt_.update_stats_path << ", layout by basket only"
+                << std::endl;
+    }
+    std::set<std::string> basket;
+    std::stringstream ss(opt_.basket_csvs);
+    std::string path;
+    while (std::getline(ss, path, ',')) {
+      path = Trim(path);
+      if (path.empty()) continue;
+      std::vector<std::string> codes;
+      if (!ParseCsvSymbols(path, &codes)) continue;
+      basket.insert(codes.begin(), codes.end());
+    }
+    ApplyFrequencyLayout(counts, basket, &wind_codes_);
+    std::cout << "[md_gate] layout by frequency: stats=" << counts.size() << " basket=" << basket.size()
+              << " hot[0]=" << (wind_codes_.empty() ? std::string("-") : wind_codes_[0]) << std::endl;
+  }
+
   static void OnDataReceived(THANDLE hTdf, TDF_MSG* pMsgHead) {
     MdGateApp* self = g_app_.load(std::memory_order_acquire);
     if (!self) return;
@@ -869,7 +1117,11 @@ private:
 
   void HandleData(TDF_MSG* msg) {
     if (!msg || !msg->pData) return;
-    if (msg->nDataType != MSG_DATA_MARKET) return;
+    if (msg->nDataType != MSG_DATA_MARKET && msg->nDataType != MSG_DATA_TRANSACTION &&
+        msg->nDataType != MSG_DATA_ORDER && msg->nDataType != MSG_DATA_ORDERQUEUE &&
+        msg->nDataType != MSG_DATA_INDEX) {
+      return;
+    }
 
     in_callback_.fetch_add(1, std::memory_order_acq_rel);
     struct Guard {
@@ -878,14 +1130,44 @@ private:
       ~Guard() { c->fetch_sub(1, std::memory_order_acq_rel); }
     } guard(&in_callback_);
 
-    if (!msg->pAppHead) return;
+    // nOrder numbers every data message of a connection (0 = not filled by this SDK build).
+    if (msg->nOrder != 0) {
+      gaps_.Observe(feed_stream_key(0, kFeedStreamTdfMsg, static_cast<uint32_t>(msg->nConnectId)),
+                    static_cast<uint32_t>(msg->nOrder), NowMonotonicNs());
+    }
+
+    switch (msg->nDataType) {
+      case MSG_DATA_MARKET:
+        HandleMarket(msg);
+        break;
+      case MSG_DATA_TRANSACTION:
+        HandleTransactions(msg);
+        break;
+      case MSG_DATA_ORDER:
+        HandleOrders(msg);
+        break;
+      case MSG_DATA_ORDERQUEUE:
+        HandleOrderQueues(msg);
+        break;
+      case MSG_DATA_INDEX:
+        HandleIndices(msg);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Validates the app head of a data message carrying items of item_bytes each; returns the item count
+  // (0 = drop the message).
+  static int CheckItems(const TDF_MSG* msg, size_t item_bytes) {
+    if (!msg->pAppHead) return 0;
     const int item_count = msg->pAppHead->nItemCount;
     const int item_size = msg->pAppHead->nItemSize;
     const int head_size = msg->pAppHead->nHeadSize;
-    if (item_count <= 0) return;
-    if (item_count > 100000) return;
-    if (item_size != static_cast<int>(sizeof(TDF_MARKET_DATA))) return;
-    if (head_size <= 0 || head_size > 1024) return;
+    if (item_count <= 0) return 0;
+    if (item_count > 100000) return 0;
+    if (item_size != static_cast<int>(item_bytes)) return 0;
+    if (head_size <= 0 || head_size > 1024) return 0;
 
     // TDFAPIStruct.h says nDataLen "includes TDF_APP_HEAD length", but some SDK builds / platforms may
     // report nDataLen as only payload bytes. Accept either to avoid dropping valid snapshots.
@@ -894,21 +1176,195 @@ private:
     const uint64_t with_head_need = static_cast<uint64_t>(head_size) + payload_need;
     if (msg->nDataLen > 0) {
       const uint64_t got = static_cast<uint64_t>(msg->nDataLen);
-      if (got < payload_need && got < with_head_need) return;
+      if (got < payload_need && got < with_head_need) return 0;
     }
+    return item_count;
+  }
+
+  // Tick-by-tick trades -> transaction ring (one record per trade, in feed order).
+  void HandleTransactions(TDF_MSG* msg) {
+    if (!writer_.transaction_ring()) return;
+    const int item_count = CheckItems(msg, sizeof(TDF_TRANSACTION));
+    if (item_count == 0) return;
+
+    const TDF_TRANSACTION* t = reinterpret_cast<const TDF_TRANSACTION*>(msg->pData);
+    const uint64_t now_ns = NowMonotonicNs();
+    for (int i = 0; i < item_count; ++i) {
+      uint32_t key = 0;
+      if (!parse_wind_code_key(t[i].szWindCode, &key, nullptr)) continue;
+      const uint32_t symbol_id = LookupSymbolId(key);
+      // Every record consumes a sequence number, subscribed universe or not.
+      ObserveTickSeq(key, t[i].nChannel, t[i].nBizIndex, static_cast<uint32_t>(t[i].nIndex), kFeedStreamShTrade,
+                     symbol_id, now_ns);
+      if (symbol_id == kInvalidSymbolId) continue;
+
+      TransactionRecord rec;
+      std::memset(&rec, 0, sizeof(rec));
+      rec.symbol_id = symbol_id;
+      rec.time_hhmmssmmm = t[i].nTime;
+      rec.index = t[i].nIndex;
+      rec.channel = t[i].nChannel;
+      rec.price_x10000 = t[i].nPrice;
+      rec.turnover = t[i].nTurnover;
+      rec.biz_index = t[i].nBizIndex;
+      rec.volume = t[i].nVolume;
+      rec.ask_order = t[i].nAskOrder;
+      rec.bid_order = t[i].nBidOrder;
+      rec.bs_flag = static_cast<char>(t[i].nBSFlag);
+      rec.order_kind = t[i].chOrderKind;
+      rec.function_code = t[i].chFunctionCode;
+      writer_.PublishTransaction(rec);
+      if (l3_.enabled() && IsL3BookKey(key)) {
+        // The cancelled order's price is only known while it is still in the book.
+        int64_t price = 0;
+        bool bid = false;
+        if (erosion_.enabled() && rec.function_code == 'C' &&
+            l3_.LookupOrder(rec.channel, rec.bid_order, &price, &bid) && bid) {
+          erosion_.OnBidCancel(symbol_id, rec.time_hhmmssmmm, price, rec.volume);
+        }
+        l3_.OnTransaction(rec);
+      }
+      // SZ cancels ('C') travel on the trade stream with price 0.
+      if (rec.function_code != 'C' && rec.price_x10000 > 0 && rec.volume > 0) {
+        if (live_.enabled()) live_.OnTrade(symbol_id, rec.time_hhmmssmmm, rec.price_x10000, rec.volume, rec.turnover);
+        if (erosion_.enabled()) erosion_.OnTrade(symbol_id, rec.time_hhmmssmmm, rec.price_x10000, rec.volume);
+      }
+    }
+    if (l3_.enabled()) l3_.Flush(now_ns);
+    if (live_.enabled()) live_.Flush(now_ns);
+    if (erosion_.enabled()) erosion_.Flush();
+  }
+
+  // Tick-by-tick orders -> order ring (pCodeInfo is replaced by symbol_id).
+  void HandleOrders(TDF_MSG* msg) {
+    if (!writer_.order_ring()) return;
+    const int item_count = CheckItems(msg, sizeof(TDF_ORDER));
+    if (item_count == 0) return;
+
+    const TDF_ORDER* o = reinterpret_cast<const TDF_ORDER*>(msg->pData);
+    const uint64_t now_ns = NowMonotonicNs();
+    for (int i = 0; i < item_count; ++i) {
+      uint32_t key = 0;
+      if (!parse_wind_code_key(o[i].szWindCode, &key, nullptr)) continue;
+      const uint32_t symbol_id = LookupSymbolId(key);
+      ObserveTickSeq(key, o[i].nChannel, o[i].nBizIndex, static_cast<uint32_t>(o[i].nOrder), kFeedStreamShOrder,
+                     symbol_id, now_ns);
+      if (symbol_id == kInvalidSymbolId) continue;
+
+      OrderRecord rec;
+      std::memset(&rec, 0, sizeof(rec));
+      rec.symbol_id = symbol_id;
+      rec.time_hhmmssmmm = o[i].nTime;
+      rec.order_no = o[i].nOrder;
+      rec.channel = o[i].nChannel;
+      rec.price_x10000 = o[i].nPrice;
+      rec.orig_order_no = o[i].nOrderOriNo;
+      rec.biz_index = o[i].nBizIndex;
+      rec.volume = o[i].nVolume;
+      rec.order_kind = o[i].chOrderKind;
+      rec.function_code = o[i].chFunctionCode;
+      writer_.PublishOrder(rec);
+      if (l3_.enabled() && IsL3BookKey(key)) l3_.OnOrder(rec);
+      // SH cancels are order records: order_kind 'D' with the price of the withdrawn order.
+      if (erosion_.enabled() && rec.order_kind == 'D' && rec.function_code == 'B') {
+        erosion_.OnBidCancel(symbol_id, rec.time_hhmmssmmm, rec.price_x10000, rec.volume);
+      }
+    }
+    if (l3_.enabled()) l3_.Flush(now_ns);
+    if (erosion_.enabled()) erosion_.Flush();
+  }
+
+  // SZ stocks (000-009xxx main board, 30xxxx ChiNext): the books the L3 builder rebuilds. Funds and
+  // bonds trade on a 0.001 grid and are left out.
+  static bool IsL3BookKey(uint32_t key) { return key < 10000u || (key >= 300000u && key < 310000u); }
+
+  // Tick record -> gap tracker. SH feeds with nBizIndex number trades and orders of a channel in one
+  // sequence; otherwise SZ trades and orders share ApplSeqNum per channel and SH numbers them apart.
+  void ObserveTickSeq(uint32_t key, int channel, int64_t biz_index, uint32_t seq, uint32_t sh_kind,
+                      uint32_t symbol_id, uint64_t now_ns) {
+    const uint32_t market = key / 1000000u;
+    const uint32_t ch = static_cast<uint32_t>(channel);
+    if (biz_index > 0) {
+      gaps_.ObserveTick(feed_stream_key(market, kFeedStreamBizIndex, ch), static_cast<uint64_t>(biz_index),
+                        symbol_id, now_ns);
+    } else if (seq != 0) {
+      gaps_.ObserveTick(feed_stream_key(market, market == 0 ? kFeedStreamSzApplSeq : sh_kind, ch), seq,
+                        symbol_id, now_ns);
+    }
+  }
+
+  // Best-price order queues -> order queue table (one side per item).
+  void HandleOrderQueues(TDF_MSG* msg) {
+    if (!writer_.order_queues()) return;
+    const int item_count = CheckItems(msg, sizeof(TDF_ORDER_QUEUE));
+    if (item_count == 0) return;
+
+    const TDF_ORDER_QUEUE* q = reinterpret_cast<const TDF_ORDER_QUEUE*>(msg->pData);
+    const uint64_t now_ns = NowMonotonicNs();
+    for (int i = 0; i < item_count; ++i) {
+      uint32_t side = 0;
+      if (q[i].nSide == 'B') {
+        side = kOrderQueueBid;
+      } else if (q[i].nSide == 'A' || q[i].nSide == 'S') {
+        side = kOrderQueueAsk;
+      } else {
+        continue;
+      }
+      uint32_t key = 0;
+      if (!parse_wind_code_key(q[i].szWindCode, &key, nullptr)) continue;
+      const uint32_t symbol_id = LookupSymbolId(key);
+      if (symbol_id == kInvalidSymbolId) continue;
+
+      const uint32_t items = (q[i].nABItems > 0) ? static_cast<uint32_t>(q[i].nABItems) : 0;
+      writer_.UpdateOrderQueue(symbol_id, side, q[i].nTime, q[i].nPrice, q[i].nOrders, q[i].nABVolume, items,
+                               now_ns);
+    }
+  }
+
+  // Index levels -> index table (codes registered from --indices at Init).
+  void HandleIndices(TDF_MSG* msg) {
+    if (!writer_.index_entries()) return;
+    const int item_count = CheckItems(msg, sizeof(TDF_INDEX_DATA));
+    if (item_count == 0) return;
+
+    const TDF_INDEX_DATA* x = reinterpret_cast<const TDF_INDEX_DATA*>(msg->pData);
+    for (int i = 0; i < item_count; ++i) {
+      const uint32_t index_id = writer_.FindIndex(x[i].szWindCode);
+      if (index_id == kInvalidSymbolId) continue;
+      IndexValues v;
+      v.open_x10000 = x[i].nOpenIndex;
+      v.high_x10000 = x[i].nHighIndex;
+      v.low_x10000 = x[i].nLowIndex;
+      v.last_x10000 = x[i].nLastIndex;
+      v.pre_close_x10000 = x[i].nPreCloseIndex;
+      v.volume = x[i].iTotalVolume;
+      v.turnover = x[i].iTurnover;
+      writer_.UpdateIndex(index_id, x[i].nTime, v);
+    }
+  }
+
+  void HandleMarket(TDF_MSG* msg) {
+    const int item_count = CheckItems(msg, sizeof(TDF_MARKET_DATA));
+    if (item_count == 0) return;
 
     const TDF_MARKET_DATA* m = reinterpret_cast<const TDF_MARKET_DATA*>(msg->pData);
     const uint64_t now_ns = NowMonotonicNs();
 
+    // One TDF message = one publish generation (readers can take a consistent cut across symbols).
+    // In coalesce mode the publisher thread brackets each drained batch instead. The bracket only covers
+    // the snapshot writes: ReadCut waits while it is open.
+    const bool coalesce = opt_.coalesce;
+    if (!coalesce) writer_.BeginPublish();
+
+    // 1) Decode and publish the snapshots.
+    staged_.clear();
     int matched = 0;
     for (int i = 0; i < item_count; ++i) {
       uint32_t key = 0;
       char wind16[16];
-      if (!ParseWindCodeKey(m[i].szWindCode, &key, wind16)) continue;
-      auto it = codekey2id_.find(key);
-      if (it == codekey2id_.end()) continue;
-      const uint32_t symbol_id = it->second;
-      if (!writer_.header() || symbol_id >= writer_.header()->symbol_count) continue;
+      if (!parse_wind_code_key(m[i].szWindCode, &key, wind16)) continue;
+      const uint32_t symbol_id = LookupSymbolId(key);
+      if (symbol_id == kInvalidSymbolId) continue;
 
       ++matched;
       LockSpin(&entry_locks_[symbol_id]);
@@ -958,11 +1414,55 @@ private:
       std::memset(md.bytes, 0, sizeof(md.bytes));
       std::memcpy(md.bytes, &payload, sizeof(payload));
 
-      writer_.UpdateSnapshot(symbol_id, md, now_ns);
-      store_u64_release(&writer_.header()->last_md_ns, now_ns);
+      if (coalesce) {
+        coalescer_.Stage(symbol_id, md, now_ns);
+      } else {
+        writer_.UpdateSnapshot(symbol_id, md, now_ns);
+        store_u64_release(&writer_.header()->last_md_ns, now_ns);
+      }
 
       UnlockSpin(&entry_locks_[symbol_id]);
 
+      StagedSnapshot staged;
+      staged.symbol_id = symbol_id;
+      staged.key = key;
+      staged.item = i;
+      staged.payload = payload;
+      staged_.push_back(staged);
+    }
+    if (!coalesce) writer_.EndPublish();
+
+    // 2) Side tables, history and the console dump, after the bracket.
+    for (size_t j = 0; j < staged_.size(); ++j) {
+      const uint32_t symbol_id = staged_[j].symbol_id;
+      const uint32_t key = staged_[j].key;
+      const int i = staged_[j].item;
+      const MarketDataPayloadV1& payload = staged_[j].payload;
+
+      if (l3_.enabled() && IsL3BookKey(key)) {
+        l3_.SetLimits(symbol_id, payload.low_limit_x10000, payload.high_limit_x10000);
+      }
+      if (live_.enabled()) {
+        live_.OnSnapshot(symbol_id, payload.time_hhmmssmmm, payload.last_x10000, payload.volume, payload.turnover);
+      }
+      if (limit_up_.enabled()) limit_up_.OnSnapshot(symbol_id, payload, now_ns);
+      if (erosion_.enabled()) erosion_.OnSnapshot(symbol_id, payload.time_hhmmssmmm);
+      // Every received snapshot, also in coalesce mode (the ring is written from this thread only).
+      if (writer_.has_history()) {
+        HistoryTick tick;
+        tick.time_hhmmssmmm = m[i].nTime;
+        tick.last_x10000 = history_price(m[i].nMatch);
+        tick.high_x10000 = history_price(m[i].nHigh);
+        tick.low_x10000 = history_price(m[i].nLow);
+        tick.bid1_x10000 = history_price(m[i].nBidPrice[0]);
+        tick.ask1_x10000 = history_price(m[i].nAskPrice[0]);
+        tick.volume = m[i].iVolume;
+        tick.turnover = m[i].iTurnover;
+        tick.bid1_vol = m[i].nBidVol[0];
+        tick.ask1_vol = m[i].nAskVol[0];
+        writer_.AppendHistory(symbol_id, tick);
+      }
+
       // Print first N snapshots for testing/verification.
       if (opt_.print_limit != 0) {
         const uint32_t idx = printed_.fetch_add(1, std::memory_order_relaxed);
@@ -998,17 +1498,28 @@ private:
       }
     }
 
+    if (live_.enabled()) live_.Flush(now_ns);
+    if (erosion_.enabled()) erosion_.Flush();
+
     // If we receive market messages but cannot match any subscribed symbol, print one hint line.
     if (matched == 0 && opt_.print_limit != 0) {
       bool expected = false;
       if (warned_no_match_.compare_exchange_strong(expected, true, std::memory_order_relaxed)) {
         std::cout << "[md_gate] recv MSG_DATA_MARKET but no symbol matched; sample wind_code=" << m[0].szWindCode
-                  << " item_count=" << item_count << " item_size=" << item_size << " head_size=" << head_size
-                  << " nDataLen=" << msg->nDataLen << std::endl;
+                  << " item_count=" << item_count << " item_size=" << msg->pAppHead->nItemSize
+                  << " head_size=" << msg->pAppHead->nHeadSize << " nDataLen=" << msg->nDataLen << std::endl;
       }
     }
   }
 
+  // packed wind_code key -> symbol_id through the SHM symbol index (the one readers probe).
+  uint32_t LookupSymbolId(uint32_t key) const {
+    const ShmHeader* h = writer_.header();
+    if (!h || !writer_.symbol_index()) return kInvalidSymbolId;
+    const uint32_t id = symbol_index_find(writer_.symbol_index(), h->symbol_index_capacity, key);
+    return (id < h->symbol_count) ? id : kInvalidSymbolId;
+  }
+
   void HandleSystem(TDF_MSG* sys) {
     if (!sys) return;
     in_callback_.fetch_add(1, std::memory_order_acq_rel);
@@ -1052,11 +1563,127 @@ private:
       case MSG_SYS_CODETABLE_RESULT:
         std::cout << "[md_gate] TDF codetable ready" << std::endl;
         break;
+      case MSG_SYS_MARKET_EVENT: {
+        const TDF_MARKET_EVENT* e = reinterpret_cast<const TDF_MARKET_EVENT*>(sys->pData);
+        if (!e) break;
+        SystemEvent ev = NewSystemEvent(kSysEventMarket);
+        ev.code = e->nEvent;
+        ev.date = e->nDate;
+        ev.aux = e->nCodeSize;
+        if (e->pCode && e->nCodeSize > 0) SetSystemEventCode(&ev, e->pCode[0].szWindCode);
+        PublishSystemEvent(&ev, e->szMarket, sizeof(e->szMarket), e->market_time);
+        if (e->nEvent == ID_MARKET_OPEN || e->nEvent == ID_MARKET_CLEAR || e->nEvent == ID_MARKET_CLOSE) {
+          std::cout << "[md_gate] TDF market event " << ev.market << " event=" << e->nEvent << " date=" << e->nDate
+                    << std::endl;
+        }
+        break;
+      }
+      case MSG_SYS_QUOTATIONDATE_CHANGE: {
+        const TDF_QUOTATIONDATE_CHANGE* d = reinterpret_cast<const TDF_QUOTATIONDATE_CHANGE*>(sys->pData);
+        if (!d) break;
+        SystemEvent ev = NewSystemEvent(kSysEventDateChange);
+        ev.date = d->nNewDate;
+        ev.aux = d->nOldDate;
+        PublishSystemEvent(&ev, d->szMarket, sizeof(d->szMarket), 0);
+        std::cout << "[md_gate] TDF quotation date change " << ev.market << " " << d->nOldDate << " -> "
+                  << d->nNewDate << std::endl;
+        break;
+      }
+      case MSG_SYS_MARKET_CLOSE: {
+        const TDF_MARKET_CLOSE* c = reinterpret_cast<const TDF_MARKET_CLOSE*>(sys->pData);
+        if (!c) break;
+        SystemEvent ev = NewSystemEvent(kSysEventMarketClose);
+        ev.aux = c->nTime;
+        PublishSystemEvent(&ev, c->szMarket, sizeof(c->szMarket), 0);
+        std::cout << "[md_gate] TDF market close " << ev.market << " time=" << c->nTime << std::endl;
+        break;
+      }
+      case MSG_SYS_ADDCODE: {
+        const TDF_ADD_CODE* a = reinterpret_cast<const TDF_ADD_CODE*>(sys->pData);
+        if (!a) break;
+        SystemEvent ev = NewSystemEvent(kSysEventAddCode);
+        ev.date = a->nCodeDate;
+        ev.aux = static_cast<int32_t>(a->nItems);
+        if (a->pCode && a->nItems > 0) SetSystemEventCode(&ev, a->pCode[0].szWindCode);
+        PublishSystemEvent(&ev, a->szMarket, sizeof(a->szMarket), 0);
+        std::cout << "[md_gate] TDF add code " << ev.market << " items=" << a->nItems << std::endl;
+        break;
+      }
+      case MSG_SYS_QUOTEUNIT_CHANGE: {
+        const TDF_QUOTEUNIT_CHANGE* q = reinterpret_cast<const TDF_QUOTEUNIT_CHANGE*>(sys->pData);
+        if (!q) break;
+        SystemEvent ev = NewSystemEvent(kSysEventQuoteUnit);
+        SetSystemEventCode(&ev, q->szWindCode);
+        PublishSystemEvent(&ev, q->szMarket, sizeof(q->szMarket), 0);
+        break;
+      }
       default:
         break;
     }
   }
 
+  static SystemEvent NewSystemEvent(uint32_t type) {
+    SystemEvent ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.type = type;
+    ev.market_id = kInvalidSymbolId;
+    ev.symbol_id = kInvalidSymbolId;
+    return ev;
+  }
+
+  void SetSystemEventCode(SystemEvent* ev, const char* wind_code) {
+    std::memset(ev->wind_code, 0, sizeof(ev->wind_code));
+    strncpy_s(ev->wind_code, wind_code, sizeof(ev->wind_code) - 1);
+    uint32_t key = 0;
+    char wind16[16];
+    if (parse_wind_code_key(ev->wind_code, &key, wind16)) ev->symbol_id = LookupSymbolId(key);
+  }
+
+  // System event -> market status block, then the event ring, so a reader woken by the event already
+  // sees the new status. System callback thread only (both are single-writer).
+  void PublishSystemEvent(SystemEvent* ev, const char* tdf_market, size_t market_bytes, int64_t market_time_ms) {
+    // TDF market keys look like "SZ-2-0": keep the exchange part.
+    size_t n = 0;
+    while (n < market_bytes && n < sizeof(ev->market) - 1 && tdf_market[n] != '\0' && tdf_market[n] != '-') ++n;
+    std::memset(ev->market, 0, sizeof(ev->market));
+    std::memcpy(ev->market, tdf_market, n);
+    ev->market_id = writer_.AddMarket(ev->market);
+    ev->recv_ns = NowMonotonicNs();
+
+    const MarketStatus* cur = writer_.market_status(ev->market_id);
+    if (cur) {
+      MarketStatus st = *cur;
+      ++st.events;
+      st.last_event_ns = ev->recv_ns;
+      switch (ev->type) {
+        case kSysEventMarket:
+          st.last_event = ev->code;
+          st.market_time_ms = market_time_ms;
+          if (ev->date != 0) st.trading_date = ev->date;
+          if (ev->code == ID_MARKET_OPEN) {
+            st.state = kMarketStateOpen;
+          } else if (ev->code == ID_MARKET_CLEAR) {
+            st.state = kMarketStateCleared;
+            ++st.clears;
+          } else if (ev->code == ID_MARKET_CLOSE) {
+            st.state = kMarketStateClosed;
+          }
+          break;
+        case kSysEventDateChange:
+          st.trading_date = ev->date;
+          ++st.date_changes;
+          break;
+        case kSysEventMarketClose:
+          st.state = kMarketStateClosed;
+          break;
+        default:
+          break;
+      }
+      writer_.UpdateMarketStatus(ev->market_id, st);
+    }
+    writer_.PublishSystemEvent(*ev);
+  }
+
 private:
   Options opt_;
   ShmWriter writer_;
@@ -1064,10 +1691,25 @@ private:
   bool connected_;
 
   std::vector<std::string> wind_codes_;
-  std::unordered_map<uint32_t, uint32_t> codekey2id_;
   std::string subscriptions_;
 
   std::vector<long> entry_locks_;
+  SnapshotCoalescer coalescer_;
+  FeedGapTracker gaps_;  // callback thread only
+  L3BookBuilder l3_;     // callback thread only
+  LiveTradeOverlay live_;  // callback thread only
+  LimitUpTracker limit_up_;  // callback thread only
+  // Snapshots of the market message being handled, for the pass after the publish bracket.
+  struct StagedSnapshot {
+    uint32_t symbol_id;
+    uint32_t key;
+    int item;
+    MarketDataPayloadV1 payload;
+  };
+  std::vector<StagedSnapshot> staged_;  // callback thread only
+  SealErosionTracker erosion_;  // callback thread only
+  std::thread publisher_;
+  std::atomic<bool> publishing_{false};
   std::atomic<bool> running_{false};
   std::atomic<uint32_t> in_callback_{0};
   std::atomic<uint32_t> printed_{0};
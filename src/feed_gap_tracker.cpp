@@ -0,0 +1,163 @@
+#include "feed_gap_tracker.h"
+
+#include <string.h>
+
+namespace mdg {
+
+FeedGapTracker::FeedGapTracker() : writer_(nullptr), last_hit_(0), unpublished_(0) {}
+
+void FeedGapTracker::Init(ShmWriter* writer, uint32_t symbol_count) {
+  writer_ = writer;
+  streams_.clear();
+  streams_.reserve(kMaxFeedStreams);
+  last_hit_ = 0;
+  symbol_stream_.assign(symbol_count, static_cast<uint8_t>(kNoStream));
+  unpublished_ = 0;
+}
+
+uint64_t FeedGapTracker::Observe(uint32_t stream_key, uint64_t seq, uint64_t now_ns) {
+  const size_t i = FindOrAdd_(stream_key);
+  if (i == streams_.size()) return 0;
+  return Advance_(&streams_[i], seq, now_ns);
+}
+
+uint64_t FeedGapTracker::ObserveTick(uint32_t stream_key, uint64_t seq, uint32_t symbol_id, uint64_t now_ns) {
+  const size_t i = FindOrAdd_(stream_key);
+  if (i == streams_.size()) return 0;
+  Stream* s = &streams_[i];
+  if (symbol_id < symbol_stream_.size() && symbol_stream_[symbol_id] == kNoStream) {
+    // A symbol trades on one channel; remember it on the first stream it shows up on.
+    // FlagSymbols_() covers the channel's other streams (SH trades vs orders).
+    symbol_stream_[symbol_id] = static_cast<uint8_t>(i);
+    s->symbols.push_back(symbol_id);
+    if (s->gaps != 0 && writer_) writer_->SetEntryFlags(symbol_id, kEntryFlagTickGap);
+  }
+  const uint64_t lost = Advance_(s, seq, now_ns);
+  if (lost != 0) FlagSymbols_(s->key);
+  return lost;
+}
+
+size_t FeedGapTracker::FindOrAdd_(uint32_t stream_key) {
+  if (last_hit_ < streams_.size() && streams_[last_hit_].key == stream_key) return last_hit_;
+  for (size_t i = 0; i < streams_.size(); ++i) {
+    if (streams_[i].key == stream_key) {
+      last_hit_ = i;
+      return i;
+    }
+  }
+  // symbol_stream_ stores indices in a byte; beyond that the stream is ignored.
+  if (streams_.size() >= kNoStream) return streams_.size();
+
+  streams_.push_back(Stream());
+  Stream* s = &streams_.back();
+  s->key = stream_key;
+  s->slot = writer_ ? writer_->AddFeedStream(stream_key) : kInvalidSymbolId;
+  if (s->slot == kInvalidSymbolId) ++unpublished_;
+  s->started = false;
+  s->next = s->high = 0;
+  s->received = s->gaps = s->gap_seqs = s->max_gap = s->late = 0;
+  s->open_hole = 0;
+  ::memset(s->window, 0, sizeof(s->window));
+  last_hit_ = streams_.size() - 1;
+  return last_hit_;
+}
+
+uint64_t FeedGapTracker::Advance_(Stream* s, uint64_t seq, uint64_t now_ns) {
+  ++s->received;
+  uint64_t lost = 0;
+
+  if (!s->started || seq + kFeedGapWindow < s->next) {
+    // First number, or a restart far below what was seen: resync.
+    s->started = true;
+    s->next = seq + 1;
+    s->high = seq;
+    s->open_hole = 0;
+    ::memset(s->window, 0, sizeof(s->window));
+    Publish_(*s);
+    return 0;
+  }
+
+  if (seq < s->next || (seq > s->next && seq < s->next + kFeedGapWindow && TestBit_(*s, seq))) {
+    ++s->late;
+    Publish_(*s);
+    return 0;
+  }
+
+  if (seq >= s->next + kFeedGapWindow) {
+    const uint64_t before = s->gap_seqs;
+    GiveUpTo_(s, seq - kFeedGapWindow + 1, now_ns);
+    lost = s->gap_seqs - before;
+  }
+
+  if (seq == s->next) {
+    ++s->next;
+    s->open_hole = 0;
+    while (s->next <= s->high && TestBit_(*s, s->next)) {
+      ClearBit_(s, s->next);
+      ++s->next;
+    }
+  } else {
+    SetBit_(s, seq);
+  }
+  if (seq > s->high) s->high = seq;
+  Publish_(*s);
+  return lost;
+}
+
+// Moves next up to new_next, counting every unreceived number below it as lost. A hole given up
+// across several calls (the window slides one number at a time) is still one gap.
+void FeedGapTracker::GiveUpTo_(Stream* s, uint64_t new_next, uint64_t now_ns) {
+  const uint64_t window_end = s->next + kFeedGapWindow;
+  const uint64_t scan_end = (new_next < window_end) ? new_next : window_end;
+  for (uint64_t q = s->next; q < scan_end; ++q) {
+    if (TestBit_(*s, q)) {
+      ClearBit_(s, q);
+      s->open_hole = 0;
+    } else {
+      NoteLost_(s, 1, now_ns);
+    }
+  }
+  // Past the window nothing can have been received.
+  if (new_next > scan_end) NoteLost_(s, new_next - scan_end, now_ns);
+  s->next = new_next;
+
+  // Numbers received just above the hole may now be contiguous.
+  while (s->next <= s->high && TestBit_(*s, s->next)) {
+    ClearBit_(s, s->next);
+    ++s->next;
+    s->open_hole = 0;
+  }
+}
+
+void FeedGapTracker::NoteLost_(Stream* s, uint64_t missing, uint64_t now_ns) {
+  if (s->open_hole == 0) ++s->gaps;
+  s->open_hole += missing;
+  s->gap_seqs += missing;
+  if (s->open_hole > s->max_gap) s->max_gap = s->open_hole;
+  if (s->slot != kInvalidSymbolId) {
+    store_u64_relaxed(&writer_->feed_stats()[s->slot].last_gap_ns, now_ns);
+  }
+}
+
+void FeedGapTracker::Publish_(const Stream& s) {
+  if (s.slot == kInvalidSymbolId) return;
+  FeedStreamStats* st = &writer_->feed_stats()[s.slot];
+  store_u64_relaxed(&st->last_seq, s.high);
+  store_u64_relaxed(&st->received, s.received);
+  store_u64_relaxed(&st->gaps, s.gaps);
+  store_u64_relaxed(&st->gap_seqs, s.gap_seqs);
+  store_u64_relaxed(&st->max_gap, s.max_gap);
+  store_u64_relaxed(&st->late, s.late);
+}
+
+void FeedGapTracker::FlagSymbols_(uint32_t stream_key) {
+  if (!writer_) return;
+  const uint32_t channel_bits = stream_key & ~(0xFu << 24);  // same market + channel, any kind
+  for (size_t k = 0; k < streams_.size(); ++k) {
+    const Stream& s = streams_[k];
+    if ((s.key & ~(0xFu << 24)) != channel_bits) continue;
+    for (size_t i = 0; i < s.symbols.size(); ++i) writer_->SetEntryFlags(s.symbols[i], kEntryFlagTickGap);
+  }
+}
+
+} // namespace mdg
@@ -0,0 +1,95 @@
+#pragma once
+
+// Gateway-side sequence-integrity checks on the feed (stats in the SHM feed_stats region).
+//
+// Each sequenced stream (see feed_stream_key() / kFeedStream*) keeps:
+// - next: lowest sequence number not received yet
+// - a kFeedGapWindow-bit window of received numbers above next, so records of one channel that arrive
+//   out of order across messages are absorbed
+// A hole is only given up (= gap) once a number kFeedGapWindow past it arrives. Numbers below next are
+// counted as late; a jump back by more than the window (feed restart / reconnect) resyncs the stream
+// without counting a gap.
+//
+// On a gap in a tick stream every symbol seen on that channel gets kEntryFlagTickGap, and so does a
+// symbol first seen on a stream after it had gaps (its earlier records may be the lost ones).
+//
+// Threading: Observe*() only from the TDF callback thread; the SHM stats are single-writer.
+
+#include "shm_writer.h"
+#include "struct_def.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+namespace mdg {
+
+class FeedGapTracker {
+public:
+  FeedGapTracker();
+
+  FeedGapTracker(const FeedGapTracker&) = delete;
+  FeedGapTracker& operator=(const FeedGapTracker&) = delete;
+
+  // Binds to the writer's stats region and sizes the per-symbol stream map (not on the hot path).
+  void Init(ShmWriter* writer, uint32_t symbol_count);
+
+  // One sequence number of a stream. Returns the count of sequence numbers given up as lost by this
+  // call (0 in the normal case).
+  uint64_t Observe(uint32_t stream_key, uint64_t seq, uint64_t now_ns);
+
+  // Same for a tick stream record of symbol_id; flags the stream's symbols on a gap.
+  uint64_t ObserveTick(uint32_t stream_key, uint64_t seq, uint32_t symbol_id, uint64_t now_ns);
+
+  // Streams that did not fit in the SHM stats region (tracked locally, not published).
+  uint32_t unpublished() const { return unpublished_; }
+
+private:
+  static const uint32_t kWindowWords = kFeedGapWindow / 64;
+  static const uint8_t kNoStream = 0xFF;
+
+  struct Stream {
+    uint32_t key;
+    uint32_t slot;          // FeedStreamStats index, kInvalidSymbolId if unpublished
+    bool started;
+    uint64_t next;
+    uint64_t high;
+    uint64_t received;
+    uint64_t gaps;
+    uint64_t gap_seqs;
+    uint64_t max_gap;
+    uint64_t late;
+    uint64_t open_hole;             // numbers given up so far in the hole just below next (0 = none)
+    uint64_t window[kWindowWords];  // bit (seq % kFeedGapWindow) = received, for seq in (next, next + window)
+    std::vector<uint32_t> symbols;  // symbols first seen on this stream (tick streams only)
+  };
+
+  size_t FindOrAdd_(uint32_t stream_key);
+  uint64_t Advance_(Stream* s, uint64_t seq, uint64_t now_ns);
+  void GiveUpTo_(Stream* s, uint64_t new_next, uint64_t now_ns);
+  void NoteLost_(Stream* s, uint64_t missing, uint64_t now_ns);
+  void Publish_(const Stream& s);
+  void FlagSymbols_(uint32_t stream_key);
+
+  inline bool TestBit_(const Stream& s, uint64_t seq) const {
+    const uint64_t b = seq % kFeedGapWindow;
+    return (s.window[b >> 6] >> (b & 63)) & 1u;
+  }
+  inline void SetBit_(Stream* s, uint64_t seq) {
+    const uint64_t b = seq % kFeedGapWindow;
+    s->window[b >> 6] |= (1ull << (b & 63));
+  }
+  inline void ClearBit_(Stream* s, uint64_t seq) {
+    const uint64_t b = seq % kFeedGapWindow;
+    s->window[b >> 6] &= ~(1ull << (b & 63));
+  }
+
+  ShmWriter* writer_;
+  std::vector<Stream> streams_;
+  size_t last_hit_;                   // streams_ index of the previous Observe (streams repeat in bursts)
+  std::vector<uint8_t> symbol_stream_;  // symbol_id -> streams_ index, kNoStream if not seen yet
+  uint32_t unpublished_;
+};
+
+} // namespace mdg
@@ -0,0 +1,275 @@
+#include "l3_book_builder.h"
+
+#include <string.h>
+
+namespace mdg {
+
+L3BookBuilder::L3BookBuilder()
+    : writer_(nullptr), free_head_(kNoNode), table_mask_(0), live_orders_(0), unknown_refs_(0) {}
+
+void L3BookBuilder::Init(ShmWriter* writer, uint32_t symbol_count, uint32_t max_orders) {
+  if (max_orders == 0) max_orders = kDefaultL3MaxOrders;
+  writer_ = writer;
+
+  books_.resize(symbol_count);
+  for (size_t i = 0; i < books_.size(); ++i) {
+    Book* b = &books_[i];
+    b->low_x10000 = 0;
+    b->levels = 0;
+    b->best_bid = -1;
+    b->best_ask = 0;
+    b->side_levels[kBid] = b->side_levels[kAsk] = 0;
+    b->flags = 0;
+    b->live_orders = 0;
+    b->time_hhmmssmmm = 0;
+    b->last_appl_seq = 0;
+    b->dirty = false;
+    b->ladder.clear();
+  }
+
+  nodes_.resize(max_orders);
+  for (uint32_t i = 0; i + 1 < max_orders; ++i) nodes_[i].symbol_id = i + 1;
+  nodes_[max_orders - 1].symbol_id = kNoNode;
+  free_head_ = 0;
+
+  // Load factor <= 0.5 keeps linear probes short.
+  size_t cap = 1;
+  while (cap < static_cast<size_t>(max_orders) * 2) cap <<= 1;
+  table_.assign(cap, static_cast<uint32_t>(kNoNode));
+  table_mask_ = cap - 1;
+
+  dirty_.clear();
+  dirty_.reserve(symbol_count);
+  live_orders_ = 0;
+  unknown_refs_ = 0;
+}
+
+void L3BookBuilder::SetLimits(uint32_t symbol_id, int64_t low_limit_x10000, int64_t high_limit_x10000) {
+  if (symbol_id >= books_.size()) return;
+  Book* b = &books_[symbol_id];
+  if (b->levels != 0) return;
+  if (low_limit_x10000 <= 0 || high_limit_x10000 < low_limit_x10000) return;
+  const int64_t levels = (high_limit_x10000 - low_limit_x10000) / kTickX10000 + 1;
+  if (levels > static_cast<int64_t>(kMaxLadderLevels)) return;
+
+  Level zero;
+  ::memset(&zero, 0, sizeof(zero));
+  b->ladder.assign(static_cast<size_t>(levels), zero);
+  b->low_x10000 = low_limit_x10000;
+  b->levels = static_cast<int32_t>(levels);
+  b->best_bid = -1;
+  b->best_ask = b->levels;
+}
+
+void L3BookBuilder::OnOrder(const OrderRecord& rec) {
+  if (rec.symbol_id >= books_.size() || rec.volume <= 0) return;
+  uint8_t side;
+  if (rec.function_code == 'B') {
+    side = kBid;
+  } else if (rec.function_code == 'S') {
+    side = kAsk;
+  } else {
+    return;
+  }
+
+  Book* b = &books_[rec.symbol_id];
+  Touch_(rec.symbol_id, rec.time_hhmmssmmm, static_cast<uint64_t>(rec.order_no));
+  if (b->levels == 0) {
+    b->flags |= kL3BookIncomplete;
+    return;
+  }
+
+  int32_t level;
+  const int32_t counter_best = (side == kBid) ? (b->best_ask < b->levels ? b->best_ask : -1) : b->best_bid;
+  const int32_t own_best = (side == kBid) ? b->best_bid : (b->best_ask < b->levels ? b->best_ask : -1);
+  if (rec.order_kind == '1') {
+    level = counter_best;
+  } else if (rec.order_kind == 'U') {
+    level = own_best;
+  } else {
+    const int64_t off = rec.price_x10000 - b->low_x10000;
+    if (off < 0 || (off % kTickX10000) != 0 || off / kTickX10000 >= b->levels) {
+      b->flags |= kL3BookIncomplete;
+      return;
+    }
+    level = static_cast<int32_t>(off / kTickX10000);
+  }
+  if (level < 0) return;  // nothing to rest against: the exchange fills or cancels it outright
+
+  if (free_head_ == kNoNode) {
+    b->flags |= kL3BookIncomplete;
+    return;
+  }
+  const uint64_t key = OrderKey_(rec.channel, rec.order_no);
+  const size_t slot = FindSlot_(key);
+  if (table_[slot] != kNoNode) return;  // duplicate ApplSeqNum
+
+  const uint32_t idx = free_head_;
+  OrderNode* n = &nodes_[idx];
+  free_head_ = n->symbol_id;
+  n->key = key;
+  n->symbol_id = rec.symbol_id;
+  n->level = level;
+  n->volume = rec.volume;
+  n->side = side;
+  table_[slot] = idx;
+
+  Level* lv = &b->ladder[static_cast<size_t>(level)];
+  if (lv->orders[side]++ == 0) ++b->side_levels[side];
+  lv->volume[side] += rec.volume;
+  if (side == kBid) {
+    if (level > b->best_bid) b->best_bid = level;
+  } else {
+    if (level < b->best_ask) b->best_ask = level;
+  }
+  ++b->live_orders;
+  ++live_orders_;
+}
+
+void L3BookBuilder::OnTransaction(const TransactionRecord& rec) {
+  if (rec.symbol_id >= books_.size()) return;
+  Touch_(rec.symbol_id, rec.time_hhmmssmmm, static_cast<uint64_t>(rec.index));
+  if (books_[rec.symbol_id].levels == 0) return;
+
+  if (rec.function_code == 'C') {
+    Reduce_(rec.channel, (rec.bid_order != 0) ? rec.bid_order : rec.ask_order, rec.volume);
+  } else {
+    Reduce_(rec.channel, rec.bid_order, rec.volume);
+    Reduce_(rec.channel, rec.ask_order, rec.volume);
+  }
+}
+
+bool L3BookBuilder::LookupOrder(int32_t channel, int64_t appl_seq, int64_t* price_x10000, bool* bid) const {
+  if (appl_seq <= 0 || table_.empty()) return false;
+  const uint32_t idx = table_[FindSlot_(OrderKey_(channel, appl_seq))];
+  if (idx == kNoNode) return false;
+  const OrderNode& n = nodes_[idx];
+  if (price_x10000) *price_x10000 = books_[n.symbol_id].low_x10000 + static_cast<int64_t>(n.level) * kTickX10000;
+  if (bid) *bid = n.side == kBid;
+  return true;
+}
+
+void L3BookBuilder::Flush(uint64_t now_ns) {
+  for (size_t i = 0; i < dirty_.size(); ++i) {
+    Publish_(dirty_[i], now_ns);
+    books_[dirty_[i]].dirty = false;
+  }
+  dirty_.clear();
+}
+
+size_t L3BookBuilder::FindSlot_(uint64_t key) const {
+  size_t i = Home_(key);
+  while (table_[i] != kNoNode && nodes_[table_[i]].key != key) i = (i + 1) & table_mask_;
+  return i;
+}
+
+// Backward-shift deletion: no tombstones, so probes stay as short as the live load.
+void L3BookBuilder::EraseSlot_(size_t slot) {
+  size_t i = slot;
+  size_t j = slot;
+  for (;;) {
+    j = (j + 1) & table_mask_;
+    if (table_[j] == kNoNode) break;
+    const size_t k = Home_(nodes_[table_[j]].key);
+    // The entry at j may move to i only if its home is not cyclically within (i, j].
+    const bool stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+    if (stays) continue;
+    table_[i] = table_[j];
+    i = j;
+  }
+  table_[i] = kNoNode;
+}
+
+void L3BookBuilder::Reduce_(int32_t channel, int64_t appl_seq, int64_t volume) {
+  if (appl_seq <= 0) return;
+  const size_t slot = FindSlot_(OrderKey_(channel, appl_seq));
+  const uint32_t idx = table_[slot];
+  if (idx == kNoNode) {
+    ++unknown_refs_;
+    return;
+  }
+
+  OrderNode* n = &nodes_[idx];
+  Book* b = &books_[n->symbol_id];
+  const uint8_t side = n->side;
+  const int32_t level = n->level;
+  Level* lv = &b->ladder[static_cast<size_t>(level)];
+  const int32_t take = (volume <= 0 || volume >= n->volume) ? n->volume : static_cast<int32_t>(volume);
+  lv->volume[side] -= take;
+  n->volume -= take;
+  if (n->volume > 0) return;
+
+  EraseSlot_(slot);
+  n->symbol_id = free_head_;
+  free_head_ = idx;
+  --b->live_orders;
+  --live_orders_;
+
+  if (--lv->orders[side] != 0) return;
+  lv->volume[side] = 0;
+  --b->side_levels[side];
+  if (side == kBid) {
+    if (level == b->best_bid) {
+      while (b->best_bid >= 0 && b->ladder[static_cast<size_t>(b->best_bid)].orders[kBid] == 0) --b->best_bid;
+    }
+  } else {
+    if (level == b->best_ask) {
+      while (b->best_ask < b->levels && b->ladder[static_cast<size_t>(b->best_ask)].orders[kAsk] == 0) {
+        ++b->best_ask;
+      }
+    }
+  }
+}
+
+void L3BookBuilder::Touch_(uint32_t symbol_id, int32_t time_hhmmssmmm, uint64_t appl_seq) {
+  Book* b = &books_[symbol_id];
+  b->time_hhmmssmmm = time_hhmmssmmm;
+  b->last_appl_seq = appl_seq;
+  if (!b->dirty) {
+    b->dirty = true;
+    dirty_.push_back(symbol_id);
+  }
+}
+
+void L3BookBuilder::Publish_(uint32_t symbol_id, uint64_t now_ns) {
+  const Book& b = books_[symbol_id];
+  L3BookHead head;
+  ::memset(&head, 0, sizeof(head));
+  head.time_hhmmssmmm = b.time_hhmmssmmm;
+  head.flags = b.flags | ((b.levels != 0) ? kL3BookValid : 0);
+  head.live_orders = b.live_orders;
+  head.last_appl_seq = b.last_appl_seq;
+  head.last_update_ns = now_ns;
+
+  L3Level bids[kL3BookLevels];
+  L3Level asks[kL3BookLevels];
+  const uint32_t want_bids =
+      (static_cast<uint32_t>(b.side_levels[kBid]) < kL3BookLevels) ? b.side_levels[kBid] : kL3BookLevels;
+  const uint32_t want_asks =
+      (static_cast<uint32_t>(b.side_levels[kAsk]) < kL3BookLevels) ? b.side_levels[kAsk] : kL3BookLevels;
+  uint32_t n = 0;
+  for (int32_t i = b.best_bid; i >= 0 && n < want_bids; --i) {
+    const Level& lv = b.ladder[static_cast<size_t>(i)];
+    if (lv.orders[kBid] == 0) continue;
+    bids[n].price_x10000 = b.low_x10000 + static_cast<int64_t>(i) * kTickX10000;
+    bids[n].volume = lv.volume[kBid];
+    bids[n].orders = lv.orders[kBid];
+    bids[n]._pad0 = 0;
+    ++n;
+  }
+  head.bid_levels = n;
+  n = 0;
+  for (int32_t i = b.best_ask; i < b.levels && n < want_asks; ++i) {
+    const Level& lv = b.ladder[static_cast<size_t>(i)];
+    if (lv.orders[kAsk] == 0) continue;
+    asks[n].price_x10000 = b.low_x10000 + static_cast<int64_t>(i) * kTickX10000;
+    asks[n].volume = lv.volume[kAsk];
+    asks[n].orders = lv.orders[kAsk];
+    asks[n]._pad0 = 0;
+    ++n;
+  }
+  head.ask_levels = n;
+  writer_->UpdateL3Book(symbol_id, head, bids, asks);
+}
+
+} // namespace mdg
@@ -0,0 +1,121 @@
+#pragma once
+
+// Gateway-side SZ order book rebuild from tick-by-tick orders and trades (SHM l3_book table).
+//
+// Per symbol:
+// - a direct-addressed price ladder, one level per 0.01 between the limit-down and limit-up prices
+//   (sized on the first SetLimits(); symbols without limits get no book)
+// - best bid / best ask level indices; an emptied best level rescans toward the far side
+// Orders live in a fixed pool of nodes found by (channel, ApplSeqNum) through an open-addressing
+// table, so the hot path never allocates.
+//
+// SZ semantics (TDF_ORDER / TDF_TRANSACTION):
+// - order: function_code 'B' / 'S'; order_kind '1' = market (placed at the counter best),
+//   'U' = own-side best (placed at the own best), otherwise limit at price
+// - trade: function_code 'C' = cancel of bid_order or ask_order, otherwise an execution that
+//   reduces both bid_order and ask_order by volume
+// Market orders are an approximation: the residual is kept at the counter best it arrived against.
+// Orders outside the ladder, off the 0.01 grid, or beyond the pool mark the book kL3BookIncomplete.
+//
+// Threading: callback thread only (same thread as the order and transaction handlers).
+
+#include "shm_writer.h"
+#include "struct_def.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+namespace mdg {
+
+class L3BookBuilder {
+public:
+  static const int64_t kTickX10000 = 100;          // 0.01
+  static const uint32_t kMaxLadderLevels = 1u << 17;  // caps one ladder at 3MB
+
+  L3BookBuilder();
+
+  L3BookBuilder(const L3BookBuilder&) = delete;
+  L3BookBuilder& operator=(const L3BookBuilder&) = delete;
+
+  // Allocates the order pool and lookup table (not on the hot path).
+  void Init(ShmWriter* writer, uint32_t symbol_count, uint32_t max_orders);
+  bool enabled() const { return writer_ != nullptr; }
+
+  // Price band of a symbol (from its snapshot). The first valid band sizes the ladder; later calls
+  // are ignored (limits do not move intraday).
+  void SetLimits(uint32_t symbol_id, int64_t low_limit_x10000, int64_t high_limit_x10000);
+
+  void OnOrder(const OrderRecord& rec);
+  void OnTransaction(const TransactionRecord& rec);
+
+  // Price and side of a resting order (e.g. the target of a cancel, looked up before OnTransaction()
+  // removes it). False if the order is not in the book.
+  bool LookupOrder(int32_t channel, int64_t appl_seq, int64_t* price_x10000, bool* bid) const;
+
+  // Publishes the top levels of every book touched since the last call (once per TDF message).
+  void Flush(uint64_t now_ns);
+
+  uint64_t unknown_refs() const { return unknown_refs_; }  // trades / cancels of orders not in the book
+  uint32_t live_orders() const { return live_orders_; }
+
+private:
+  static const uint32_t kNoNode = 0xFFFFFFFFu;
+  static const uint8_t kBid = 0;
+  static const uint8_t kAsk = 1;
+
+  struct Level {
+    int64_t volume[2];      // kBid / kAsk
+    int32_t orders[2];
+  };
+
+  struct Book {
+    int64_t low_x10000;     // price of ladder level 0
+    int32_t levels;         // 0 = no ladder yet
+    int32_t best_bid;       // -1 = none
+    int32_t best_ask;       // levels = none
+    int32_t side_levels[2]; // non-empty levels per side (stops the top-N scan early)
+    uint32_t flags;
+    uint32_t live_orders;
+    int32_t time_hhmmssmmm;
+    uint64_t last_appl_seq;
+    bool dirty;
+    std::vector<Level> ladder;
+  };
+
+  struct OrderNode {
+    uint64_t key;           // channel << 32 | ApplSeqNum
+    uint32_t symbol_id;     // next free node while on the free list
+    int32_t level;
+    int32_t volume;         // remaining
+    uint8_t side;
+  };
+
+  static inline uint64_t OrderKey_(int32_t channel, int64_t appl_seq) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(channel)) << 32) |
+           static_cast<uint32_t>(appl_seq);
+  }
+  inline size_t Home_(uint64_t key) const {
+    const uint64_t h = key * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h ^ (h >> 29)) & table_mask_;
+  }
+
+  size_t FindSlot_(uint64_t key) const;  // table_ index holding key, or the empty slot ending its probe
+  void EraseSlot_(size_t slot);
+  void Reduce_(int32_t channel, int64_t appl_seq, int64_t volume);
+  void Touch_(uint32_t symbol_id, int32_t time_hhmmssmmm, uint64_t appl_seq);
+  void Publish_(uint32_t symbol_id, uint64_t now_ns);
+
+  ShmWriter* writer_;
+  std::vector<Book> books_;
+  std::vector<OrderNode> nodes_;
+  uint32_t free_head_;
+  std::vector<uint32_t> table_;  // node index per slot, kNoNode = empty (linear probing)
+  size_t table_mask_;
+  std::vector<uint32_t> dirty_;  // symbols touched since the last Flush()
+  uint32_t live_orders_;
+  uint64_t unknown_refs_;
+};
+
+} // namespace mdg
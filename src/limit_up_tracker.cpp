@@ -0,0 +1,66 @@
+#include "limit_up_tracker.h"
+
+#include <string.h>
+
+namespace mdg {
+
+LimitUpTracker::LimitUpTracker() : writer_(nullptr) {}
+
+void LimitUpTracker::Init(ShmWriter* writer, uint32_t symbol_count) {
+  writer_ = writer;
+  symbols_.resize(symbol_count);
+  if (!symbols_.empty()) ::memset(&symbols_[0], 0, symbols_.size() * sizeof(Symbol));
+}
+
+void LimitUpTracker::OnSnapshot(uint32_t symbol_id, const MarketDataPayloadV1& p, uint64_t now_ns) {
+  if (symbol_id >= symbols_.size()) return;
+  const int64_t limit = p.high_limit_x10000;
+  if (limit <= 0) return;
+  Symbol* s = &symbols_[symbol_id];
+  const LimitUpState before = s->v;
+  LimitUpState* v = &s->v;
+  if (p.trading_day != s->trading_day || limit != v->limit_x10000) {
+    ::memset(v, 0, sizeof(*v));
+    v->limit_x10000 = limit;
+    s->trading_day = p.trading_day;
+  }
+
+  const bool touched = p.high_x10000 >= limit || p.last_x10000 >= limit;
+  const bool sealed = p.bid_price_x10000[0] >= limit && p.bid_vol[0] > 0 &&
+                      (p.ask_price_x10000[0] <= 0 || p.ask_vol[0] <= 0);
+  const int32_t t = p.time_hhmmssmmm;
+  if (v->state == kLimitUpNone && (touched || sealed)) {
+    v->state = kLimitUpTouched;
+    v->first_touch_time = t;
+  }
+
+  if (v->state != kLimitUpNone) {
+    if (sealed) {
+      if (v->state != kLimitUpSealed) {
+        if (v->state == kLimitUpBroken) {
+          v->reseal_time = t;
+        } else {
+          v->seal_time = t;
+        }
+        v->state = kLimitUpSealed;
+      }
+      v->seal_volume = p.bid_vol[0];
+      if (v->seal_volume > v->peak_seal_volume) v->peak_seal_volume = v->seal_volume;
+    } else {
+      if (v->state == kLimitUpSealed) {
+        v->state = kLimitUpBroken;
+        ++v->breaks;
+        v->break_time = t;
+      }
+      v->seal_volume = 0;
+    }
+  }
+
+  // Publish only on change (a restart included).
+  v->last_update_ns = before.last_update_ns;
+  if (::memcmp(v, &before, sizeof(before)) == 0) return;
+  v->last_update_ns = now_ns;
+  writer_->UpdateLimitUp(symbol_id, *v);
+}
+
+} // namespace mdg
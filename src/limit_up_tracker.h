@@ -0,0 +1,53 @@
+#pragma once
+
+// Gateway-side limit-up lifecycle per symbol (SHM limit_up table, see LimitUpState).
+//
+// Driven by snapshots only:
+// - touched: high (or last) at high_limit_x10000
+// - sealed: bid1 at the limit with volume and no ask (ask1 price or volume 0)
+// - a sealed -> not sealed step is a break; sealed again after a break is a re-seal
+// The state restarts when the snapshot's trading day or limit price changes. The SHM record is
+// only rewritten when the state changed, so symbols away from the limit cost one compare.
+//
+// Threading: callback thread only.
+
+#include "marketdata_payload.h"
+#include "shm_writer.h"
+#include "struct_def.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+namespace mdg {
+
+class LimitUpTracker {
+public:
+  LimitUpTracker();
+
+  LimitUpTracker(const LimitUpTracker&) = delete;
+  LimitUpTracker& operator=(const LimitUpTracker&) = delete;
+
+  // Allocates per-symbol state (not on the hot path).
+  void Init(ShmWriter* writer, uint32_t symbol_count);
+  bool enabled() const { return writer_ != nullptr; }
+
+  void OnSnapshot(uint32_t symbol_id, const MarketDataPayloadV1& p, uint64_t now_ns);
+
+  // Latest state of a symbol (nullptr if out of range).
+  const LimitUpState* state(uint32_t symbol_id) const {
+    return (symbol_id < symbols_.size()) ? &symbols_[symbol_id].v : nullptr;
+  }
+
+private:
+  struct Symbol {
+    LimitUpState v;
+    int32_t trading_day;
+  };
+
+  ShmWriter* writer_;
+  std::vector<Symbol> symbols_;
+};
+
+} // namespace mdg
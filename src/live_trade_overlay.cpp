@@ -0,0 +1,115 @@
+#include "live_trade_overlay.h"
+
+#include <string.h>
+
+namespace mdg {
+
+LiveTradeOverlay::LiveTradeOverlay() : writer_(nullptr) {}
+
+void LiveTradeOverlay::Init(ShmWriter* writer, uint32_t symbol_count) {
+  writer_ = writer;
+  symbols_.resize(symbol_count);
+  if (!symbols_.empty()) ::memset(&symbols_[0], 0, symbols_.size() * sizeof(Symbol));
+  dirty_.clear();
+  dirty_.reserve(symbol_count);
+}
+
+void LiveTradeOverlay::OnTrade(uint32_t symbol_id, int32_t time_hhmmssmmm, int64_t price_x10000, int64_t volume,
+                               int64_t turnover) {
+  if (symbol_id >= symbols_.size()) return;
+  Symbol* s = &symbols_[symbol_id];
+  // Arrived after a snapshot that is not older than it: already in the snapshot totals. Leaving it out
+  // of cum_* is exact for later re-bases too (their base absorbs it).
+  if ((s->flags & kLiveTradeBased) && time_hhmmssmmm <= s->snap_time) return;
+  s->cum_volume += volume;
+  s->cum_turnover += turnover;
+
+  // One checkpoint per trade millisecond; an older time (late record) folds into the newest one.
+  Checkpoint* newest = (s->cp_count != 0) ? &s->cp[(s->cp_head + kCheckpoints - 1) % kCheckpoints] : nullptr;
+  if (!newest || time_hhmmssmmm > newest->time_hhmmssmmm) {
+    if (s->cp_count == kCheckpoints) {
+      s->floor = s->cp[s->cp_head];
+    } else {
+      ++s->cp_count;
+    }
+    newest = &s->cp[s->cp_head];
+    newest->time_hhmmssmmm = time_hhmmssmmm;
+    s->cp_head = (s->cp_head + 1) % kCheckpoints;
+  }
+  newest->cum_volume = s->cum_volume;
+  newest->cum_turnover = s->cum_turnover;
+
+  if (time_hhmmssmmm >= s->trade_time) {
+    s->trade_time = time_hhmmssmmm;
+    s->trade_last = price_x10000;
+  }
+  ++s->trades;
+  if (!s->dirty) {
+    s->dirty = true;
+    dirty_.push_back(symbol_id);
+  }
+}
+
+void LiveTradeOverlay::OnSnapshot(uint32_t symbol_id, int32_t time_hhmmssmmm, int64_t last_x10000, int64_t volume,
+                                  int64_t turnover) {
+  if (symbol_id >= symbols_.size()) return;
+  Symbol* s = &symbols_[symbol_id];
+
+  // Trade totals as of the snapshot time: newest checkpoint at or before it, else the floor.
+  const Checkpoint* at = nullptr;
+  for (uint32_t i = 0; i < s->cp_count; ++i) {
+    const Checkpoint* c = &s->cp[(s->cp_head + kCheckpoints - 1 - i) % kCheckpoints];
+    if (c->time_hhmmssmmm <= time_hhmmssmmm) {
+      at = c;
+      break;
+    }
+  }
+  bool exact = true;
+  if (!at) {
+    if (s->floor.time_hhmmssmmm <= time_hhmmssmmm) {
+      at = &s->floor;
+    } else {
+      exact = false;  // the ring no longer reaches back to the snapshot time
+    }
+  }
+
+  if (exact) {
+    s->base_volume = volume - at->cum_volume;
+    s->base_turnover = turnover - at->cum_turnover;
+    s->flags |= kLiveTradeExact;
+  } else {
+    s->base_volume = volume - s->cum_volume;
+    s->base_turnover = turnover - s->cum_turnover;
+    s->flags &= ~kLiveTradeExact;
+  }
+  s->flags |= kLiveTradeBased;
+  s->snap_time = time_hhmmssmmm;
+  s->snap_last = last_x10000;
+  s->trades = 0;
+  if (!s->dirty) {
+    s->dirty = true;
+    dirty_.push_back(symbol_id);
+  }
+}
+
+void LiveTradeOverlay::Flush(uint64_t now_ns) {
+  for (size_t i = 0; i < dirty_.size(); ++i) {
+    Symbol* s = &symbols_[dirty_[i]];
+    LiveTrade v;
+    ::memset(&v, 0, sizeof(v));
+    const bool trade_newer = s->trade_time > s->snap_time;
+    v.time_hhmmssmmm = trade_newer ? s->trade_time : s->snap_time;
+    v.snapshot_time = s->snap_time;
+    v.last_x10000 = trade_newer ? s->trade_last : s->snap_last;
+    v.volume = s->base_volume + s->cum_volume;
+    v.turnover = s->base_turnover + s->cum_turnover;
+    v.trades = s->trades;
+    v.flags = s->flags;
+    v.last_update_ns = now_ns;
+    writer_->UpdateLiveTrade(dirty_[i], v);
+    s->dirty = false;
+  }
+  dirty_.clear();
+}
+
+} // namespace mdg
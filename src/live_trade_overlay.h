@@ -0,0 +1,81 @@
+#pragma once
+
+// Gateway-side live trade overlay: trades folded into last / volume / turnover between snapshots
+// (SHM live_trade table, read through ShmReader::ReadSnapshotLive).
+//
+// Per symbol the overlay keeps the totals of every trade folded since start (cum_*) and a base:
+//   published volume = base_volume + cum_volume
+// On each snapshot the base is re-computed so that the published totals equal the snapshot's at the
+// snapshot time: base = snapshot - (trade totals as of the snapshot's nTime). Trades that arrived
+// before the snapshot but are newer than it stay counted, trades it already covers are not counted
+// twice, and a trade arriving after a snapshot whose nTime is not older than it is dropped. The trade
+// totals as of a given time come from a ring of per-millisecond checkpoints; if the snapshot time is
+// older than the ring (a very active symbol), the snapshot totals are taken as they are and
+// kLiveTradeExact is cleared.
+//
+// Threading: callback thread only (snapshots and trades are delivered on the same thread).
+
+#include "shm_writer.h"
+#include "struct_def.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+namespace mdg {
+
+class LiveTradeOverlay {
+public:
+  static const uint32_t kCheckpoints = 64;  // distinct trade milliseconds remembered per symbol
+
+  LiveTradeOverlay();
+
+  LiveTradeOverlay(const LiveTradeOverlay&) = delete;
+  LiveTradeOverlay& operator=(const LiveTradeOverlay&) = delete;
+
+  // Allocates per-symbol state (not on the hot path).
+  void Init(ShmWriter* writer, uint32_t symbol_count);
+  bool enabled() const { return writer_ != nullptr; }
+
+  // One executed trade (not a cancel).
+  void OnTrade(uint32_t symbol_id, int32_t time_hhmmssmmm, int64_t price_x10000, int64_t volume, int64_t turnover);
+  // A snapshot landed: re-base the totals on it.
+  void OnSnapshot(uint32_t symbol_id, int32_t time_hhmmssmmm, int64_t last_x10000, int64_t volume,
+                  int64_t turnover);
+
+  // Publishes every overlay touched since the last call (once per TDF message).
+  void Flush(uint64_t now_ns);
+
+private:
+  struct Checkpoint {
+    int32_t time_hhmmssmmm;
+    int64_t cum_volume;     // trade totals after every trade up to and including this millisecond
+    int64_t cum_turnover;
+  };
+
+  struct Symbol {
+    int64_t cum_volume;
+    int64_t cum_turnover;
+    int64_t base_volume;
+    int64_t base_turnover;
+    int32_t trade_time;
+    int64_t trade_last;
+    int32_t snap_time;
+    int64_t snap_last;
+    uint32_t trades;
+    uint32_t flags;
+    // Totals before the oldest checkpoint still in the ring (time 0 / zero totals until it wraps).
+    Checkpoint floor;
+    uint32_t cp_head;       // next ring position
+    uint32_t cp_count;
+    bool dirty;
+    Checkpoint cp[kCheckpoints];
+  };
+
+  ShmWriter* writer_;
+  std::vector<Symbol> symbols_;
+  std::vector<uint32_t> dirty_;  // symbols touched since the last Flush()
+};
+
+} // namespace mdg
@@ -0,0 +1,232 @@
+#include "mdg_reader_c.h"
+
+#include "shm_reader.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <new>
+#include <tuple>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// The C snapshot is a byte-for-byte view of the payload: decode is one memcpy.
+static_assert(sizeof(mdg_snapshot_t) == sizeof(mdg::MarketDataPayloadV1), "mdg_snapshot_t size mismatch");
+static_assert(offsetof(mdg_snapshot_t, last_x10000) == offsetof(mdg::MarketDataPayloadV1, last_x10000),
+              "mdg_snapshot_t layout mismatch");
+static_assert(offsetof(mdg_snapshot_t, ask_vol) == offsetof(mdg::MarketDataPayloadV1, ask_vol),
+              "mdg_snapshot_t layout mismatch");
+static_assert(offsetof(mdg_snapshot_t, recv_ns) == offsetof(mdg::MarketDataPayloadV1, recv_ns),
+              "mdg_snapshot_t layout mismatch");
+static_assert(sizeof(mdg_history_tick_t) == sizeof(mdg::HistoryTick), "mdg_history_tick_t size mismatch");
+static_assert(offsetof(mdg_history_tick_t, volume) == offsetof(mdg::HistoryTick, volume),
+              "mdg_history_tick_t layout mismatch");
+static_assert(offsetof(mdg_history_tick_t, ask1_vol) == offsetof(mdg::HistoryTick, ask1_vol),
+              "mdg_history_tick_t layout mismatch");
+static_assert(MDG_INVALID_SYMBOL_ID == mdg::kInvalidSymbolId, "invalid symbol id mismatch");
+
+struct mdg_reader {
+  mdg::ShmReader reader;
+  uint64_t heartbeat_timeout_ns;
+  uint64_t max_staleness_ns;
+  bool require_md_status_ok;
+  uint64_t retry_interval_ns;  // unmapped after a failed remap: CheckWriter() at most this often
+  uint64_t next_retry_ns;
+};
+
+namespace {
+
+static uint64_t NowMonotonicNs() {
+#if defined(_WIN32)
+  LARGE_INTEGER freq;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&counter);
+  const double seconds = static_cast<double>(counter.QuadPart) / static_cast<double>(freq.QuadPart);
+  return static_cast<uint64_t>(seconds * 1000000000.0);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+// Gateway health gate shared by every read. now_ns is reused by the caller for staleness.
+static bool Connected(mdg_reader* r, uint64_t now_ns) {
+  // Remap here first: the gate below would otherwise keep every read call, and so the remap inside it,
+  // from running (a restarted gateway's old segment has a stale heartbeat).
+  if (r->reader.remap_pending()) {
+    r->reader.CheckWriter();
+  } else if (!r->reader.header() && r->retry_interval_ns != 0 && now_ns >= r->next_retry_ns) {
+    r->next_retry_ns = now_ns + r->retry_interval_ns;
+    r->reader.CheckWriter();
+  }
+  if (!r->reader.header()) return false;
+  if (r->require_md_status_ok && r->reader.md_status() != 0) return false;
+  if (r->heartbeat_timeout_ns != 0) {
+    const uint64_t hb = r->reader.heartbeat_ns();
+    if (hb == 0 || (now_ns > hb && now_ns - hb > r->heartbeat_timeout_ns)) return false;
+  }
+  return true;
+}
+
+static int StatusToCode(mdg::ReadStatus st) {
+  switch (st) {
+    case mdg::kReadOk:
+      return MDG_OK;
+    case mdg::kReadNotMapped:
+      return MDG_E_NOT_CONNECTED;
+    case mdg::kReadWriterStuck:
+      return MDG_E_WRITER_STUCK;
+    case mdg::kReadRetryExceeded:
+      return MDG_E_RETRY_EXCEEDED;
+    case mdg::kReadNotReady:
+      return MDG_E_NO_DATA;
+    default:
+      return MDG_E_INVALID_ARG;
+  }
+}
+
+static const mdg::ReadWaitPolicy& WaitPolicyFor(uint32_t id) {
+  switch (id) {
+    case MDG_WAIT_LATENCY_CRITICAL:
+      return mdg::kWaitPolicyLatencyCritical;
+    case MDG_WAIT_BACKGROUND:
+      return mdg::kWaitPolicyBackground;
+    default:
+      return mdg::kWaitPolicyDefault;
+  }
+}
+
+}  // namespace
+
+extern "C" {
+
+uint32_t mdg_reader_abi_version(void) { return MDG_READER_ABI_VERSION; }
+
+void mdg_reader_config_default(mdg_reader_config_t* cfg) {
+  if (!cfg) return;
+  ::memset(cfg, 0, sizeof(*cfg));
+  cfg->heartbeat_timeout_ms = 1000;
+  cfg->max_staleness_ms = 0;
+  cfg->require_md_status_ok = 1;
+  cfg->watch_interval_ms = 100;
+  cfg->wait_policy = MDG_WAIT_DEFAULT;
+}
+
+mdg_reader_t* mdg_reader_open(const char* shm_name, const mdg_reader_config_t* cfg) {
+  return mdg_reader_open_ex(shm_name, cfg, nullptr);
+}
+
+mdg_reader_t* mdg_reader_open_ex(const char* shm_name, const mdg_reader_config_t* cfg, int* out_errno) {
+  mdg_reader_config_t c;
+  if (cfg) {
+    c = *cfg;
+  } else {
+    mdg_reader_config_default(&c);
+  }
+
+  mdg_reader* r = new (std::nothrow) mdg_reader();
+  if (!r) {
+    if (out_errno) *out_errno = ENOMEM;
+    return nullptr;
+  }
+  r->heartbeat_timeout_ns = static_cast<uint64_t>(c.heartbeat_timeout_ms) * 1000000ULL;
+  r->max_staleness_ns = static_cast<uint64_t>(c.max_staleness_ms) * 1000000ULL;
+  r->require_md_status_ok = (c.require_md_status_ok != 0);
+  r->retry_interval_ns = static_cast<uint64_t>(c.watch_interval_ms) * 1000000ULL;
+  r->next_retry_ns = 0;
+  r->reader.SetWaitPolicy(WaitPolicyFor(c.wait_policy));
+
+  if (!r->reader.Open(shm_name)) {
+    if (out_errno) *out_errno = r->reader.last_errno() ? r->reader.last_errno() : EINVAL;
+    delete r;
+    return nullptr;
+  }
+  // Open() only maps: reject other ABI versions and half-initialized segments before any offset is used.
+  if (!r->reader.ValidateHeader()) {
+    if (out_errno) *out_errno = (r->reader.header()->total_bytes == 0) ? EAGAIN : EPROTO;
+    delete r;
+    return nullptr;
+  }
+  if (c.watch_interval_ms != 0) r->reader.StartWatcher(c.watch_interval_ms);
+  if (out_errno) *out_errno = 0;
+  return r;
+}
+
+void mdg_reader_close(mdg_reader_t* r) {
+  delete r;  // ~ShmReader stops the watcher and releases the registry slot
+}
+
+int mdg_reader_is_connected(mdg_reader_t* r) {
+  if (!r) return 0;
+  return Connected(r, NowMonotonicNs()) ? 1 : 0;
+}
+
+uint32_t mdg_reader_epoch(const mdg_reader_t* r) { return r ? r->reader.epoch() : 0; }
+
+uint32_t mdg_reader_find_symbol(const mdg_reader_t* r, const char* wind_code) {
+  if (!r || !wind_code) return MDG_INVALID_SYMBOL_ID;
+  return r->reader.FindSymbol(wind_code);
+}
+
+int mdg_reader_get_snapshot(mdg_reader_t* r, uint32_t symbol_id, mdg_snapshot_t* out, uint64_t* out_update_ns) {
+  if (!r || !out) return MDG_E_INVALID_ARG;
+  const uint64_t now = NowMonotonicNs();
+  if (!Connected(r, now)) return MDG_E_NOT_CONNECTED;
+
+  mdg::MarketData320 md;
+  if (!r->reader.ReadSnapshot(symbol_id, &md, nullptr)) return StatusToCode(r->reader.last_read_status());
+  ::memcpy(out, md.bytes, sizeof(*out));
+
+  if ((out->flags & 1U) == 0) return MDG_E_NO_DATA;
+  if (out_update_ns) *out_update_ns = out->recv_ns;
+  if (r->max_staleness_ns != 0 && now > out->recv_ns && now - out->recv_ns > r->max_staleness_ns) {
+    return MDG_E_STALE;
+  }
+  return MDG_OK;
+}
+
+int mdg_reader_get_limits(mdg_reader_t* r, uint32_t symbol_id, mdg_limits_t* out) {
+  if (!r || !out) return MDG_E_INVALID_ARG;
+  if (!Connected(r, NowMonotonicNs())) return MDG_E_NOT_CONNECTED;
+
+  typedef MDG_PAYLOAD_FIELD(flags) Flags;
+  typedef MDG_PAYLOAD_FIELD(pre_close_x10000) PreClose;
+  typedef MDG_PAYLOAD_FIELD(high_limit_x10000) HighLimit;
+  typedef MDG_PAYLOAD_FIELD(low_limit_x10000) LowLimit;
+  std::tuple<uint32_t, int64_t, int64_t, int64_t> v;
+  if (!r->reader.ReadFields<Flags, PreClose, HighLimit, LowLimit>(symbol_id, &v)) {
+    return StatusToCode(r->reader.last_read_status());
+  }
+  if ((std::get<0>(v) & 1U) == 0) return MDG_E_NO_DATA;
+  out->pre_close_x10000 = std::get<1>(v);
+  out->high_limit_x10000 = std::get<2>(v);
+  out->low_limit_x10000 = std::get<3>(v);
+  return MDG_OK;
+}
+
+int mdg_reader_get_history(mdg_reader_t* r, uint32_t symbol_id, mdg_history_tick_t* out, uint32_t max,
+                           uint32_t* out_count) {
+  if (out_count) *out_count = 0;
+  if (!r || !out || !out_count) return MDG_E_INVALID_ARG;
+  if (!Connected(r, NowMonotonicNs())) return MDG_E_NOT_CONNECTED;
+  if (symbol_id >= r->reader.symbol_count()) return MDG_E_INVALID_ARG;
+
+  const size_t n = r->reader.ReadHistory(symbol_id, reinterpret_cast<mdg::HistoryTick*>(out), max);
+  if (n == 0) return MDG_E_NO_DATA;
+  *out_count = static_cast<uint32_t>(n);
+  return MDG_OK;
+}
+
+void mdg_reader_heartbeat(mdg_reader_t* r) {
+  if (!r) return;
+  r->reader.Heartbeat(NowMonotonicNs());
+}
+
+}  // extern "C"
@@ -0,0 +1,162 @@
+#ifndef MDG_READER_C_H
+#define MDG_READER_C_H
+
+/*
+ * mdg_reader: stable C ABI over ShmReader for trade_app (no TDF headers/libs needed).
+ *
+ * Typical usage:
+ *   mdg_reader_config_t cfg;
+ *   mdg_reader_config_default(&cfg);
+ *   mdg_reader_t* r = mdg_reader_open("/md_gate_shm", &cfg);
+ *   uint32_t id = mdg_reader_find_symbol(r, "600000.SH");
+ *   mdg_snapshot_t s;
+ *   if (mdg_reader_get_snapshot(r, id, &s, NULL) == MDG_OK) { ... }
+ *   mdg_reader_close(r);
+ *
+ * Every read is gated: MDG_E_NOT_CONNECTED if the gateway heartbeat is older than
+ * heartbeat_timeout_ms (or md_status != 0 with require_md_status_ok). No call allocates except
+ * mdg_reader_open. A handle is not thread-safe: one reading thread per handle.
+ */
+
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(MDG_READER_SHARED)
+#if defined(MDG_READER_BUILD)
+#define MDG_READER_API __declspec(dllexport)
+#else
+#define MDG_READER_API __declspec(dllimport)
+#endif
+#elif defined(MDG_READER_SHARED) && defined(MDG_READER_BUILD)
+#define MDG_READER_API __attribute__((visibility("default")))
+#else
+#define MDG_READER_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MDG_READER_ABI_VERSION 1
+#define MDG_INVALID_SYMBOL_ID 0xFFFFFFFFu
+
+/* Return codes (0 = success, negative = no usable data in out). */
+enum {
+  MDG_OK = 0,
+  MDG_E_STALE = 1,           /* out filled, but the entry is older than max_staleness_ms */
+  MDG_E_NOT_CONNECTED = -1,  /* not mapped, heartbeat timed out, or md_status != 0 (if required) */
+  MDG_E_INVALID_ARG = -2,    /* null pointer or symbol_id out of range */
+  MDG_E_NO_DATA = -3,        /* symbol never updated by the gateway */
+  MDG_E_RETRY_EXCEEDED = -4, /* entry kept changing for the whole wait budget */
+  MDG_E_WRITER_STUCK = -5    /* entry parked mid-write (gateway stalled or died) */
+};
+
+typedef struct mdg_reader mdg_reader_t;
+
+/* Wait policies (see ShmReader ReadWaitPolicy presets). */
+enum {
+  MDG_WAIT_DEFAULT = 0,
+  MDG_WAIT_LATENCY_CRITICAL = 1,
+  MDG_WAIT_BACKGROUND = 2
+};
+
+typedef struct mdg_reader_config {
+  uint32_t heartbeat_timeout_ms;  /* 0 = no heartbeat gating (default 1000) */
+  uint32_t max_staleness_ms;      /* 0 = no per-entry staleness gating (default 0) */
+  uint32_t require_md_status_ok;  /* 1 = md_status != 0 counts as not connected (default 1) */
+  uint32_t watch_interval_ms;     /* >0 = follow gateway restarts (default 100) */
+  uint32_t wait_policy;           /* MDG_WAIT_* (default MDG_WAIT_DEFAULT) */
+  uint32_t reserved[3];
+} mdg_reader_config_t;
+
+/* Decoded snapshot. Field-for-field identical to mdg::MarketDataPayloadV1 (320B). */
+typedef struct mdg_snapshot {
+  uint32_t payload_version;
+  uint32_t flags;             /* bit0 = valid */
+
+  int32_t action_day;         /* yyyymmdd */
+  int32_t trading_day;        /* yyyymmdd */
+  int32_t time_hhmmssmmm;
+  int32_t status;
+
+  int64_t pre_close_x10000;
+  int64_t open_x10000;
+  int64_t high_x10000;
+  int64_t low_x10000;
+  int64_t last_x10000;
+
+  int64_t high_limit_x10000;
+  int64_t low_limit_x10000;
+
+  int64_t volume;
+  int64_t turnover;
+
+  int64_t bid_price_x10000[5];
+  int64_t bid_vol[5];
+  int64_t ask_price_x10000[5];
+  int64_t ask_vol[5];
+
+  char wind_code[16];
+  char prefix[8];
+
+  uint64_t recv_ns;           /* gateway monotonic ns */
+
+  uint64_t reserved[4];
+} mdg_snapshot_t;
+
+typedef struct mdg_limits {
+  int64_t pre_close_x10000;
+  int64_t high_limit_x10000;
+  int64_t low_limit_x10000;
+} mdg_limits_t;
+
+/* One compacted snapshot of the history ring. Field-for-field identical to mdg::HistoryTick (56B). */
+typedef struct mdg_history_tick {
+  int32_t time_hhmmssmmm;
+  int32_t last_x10000;
+  int32_t high_x10000;
+  int32_t low_x10000;
+  int32_t bid1_x10000;
+  int32_t ask1_x10000;
+  int64_t volume;             /* cumulative */
+  int64_t turnover;
+  int64_t bid1_vol;
+  int64_t ask1_vol;
+} mdg_history_tick_t;
+
+MDG_READER_API uint32_t mdg_reader_abi_version(void);
+MDG_READER_API void mdg_reader_config_default(mdg_reader_config_t* cfg);
+
+/* NULL on failure (segment missing, bad header). cfg may be NULL (defaults).
+ * _ex: errno-style reason in *out_errno (0 on success; EAGAIN = gateway still initializing,
+ * EPROTO = incompatible header). */
+MDG_READER_API mdg_reader_t* mdg_reader_open(const char* shm_name, const mdg_reader_config_t* cfg);
+MDG_READER_API mdg_reader_t* mdg_reader_open_ex(const char* shm_name, const mdg_reader_config_t* cfg,
+                                                int* out_errno);
+MDG_READER_API void mdg_reader_close(mdg_reader_t* r);
+
+/* 1 if mapped and the gating (heartbeat / md_status) passes now. */
+MDG_READER_API int mdg_reader_is_connected(mdg_reader_t* r);
+/* Incremented on every gateway restart that was followed; cached symbol ids are valid per epoch. */
+MDG_READER_API uint32_t mdg_reader_epoch(const mdg_reader_t* r);
+
+/* "600000.SH" -> symbol_id, MDG_INVALID_SYMBOL_ID if unknown. */
+MDG_READER_API uint32_t mdg_reader_find_symbol(const mdg_reader_t* r, const char* wind_code);
+
+/* Latest snapshot. out_update_ns (optional): gateway monotonic ns of the entry's last update. */
+MDG_READER_API int mdg_reader_get_snapshot(mdg_reader_t* r, uint32_t symbol_id, mdg_snapshot_t* out,
+                                           uint64_t* out_update_ns);
+/* Price limits and pre-close only (field-projected read, no full payload copy). */
+MDG_READER_API int mdg_reader_get_limits(mdg_reader_t* r, uint32_t symbol_id, mdg_limits_t* out);
+/* Newest snapshots of symbol_id (gateway --history-depth), oldest first: up to max into out, the
+ * count in *out_count. MDG_E_NO_DATA if the segment keeps no history or the symbol has none yet. */
+MDG_READER_API int mdg_reader_get_history(mdg_reader_t* r, uint32_t symbol_id, mdg_history_tick_t* out,
+                                          uint32_t max, uint32_t* out_count);
+
+/* Liveness + counters into the reader registry; call once per strategy cycle. */
+MDG_READER_API void mdg_reader_heartbeat(mdg_reader_t* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MDG_READER_C_H */
@@ -0,0 +1,148 @@
+#include "seal_erosion_tracker.h"
+
+#include <string.h>
+
+namespace mdg {
+
+SealErosionTracker::SealErosionTracker() : writer_(nullptr), limit_up_(nullptr) {}
+
+void SealErosionTracker::Init(ShmWriter* writer, uint32_t symbol_count, const LimitUpTracker* limit_up) {
+  writer_ = writer;
+  limit_up_ = limit_up;
+  symbols_.resize(symbol_count);
+  for (size_t i = 0; i < symbols_.size(); ++i) Reset_(&symbols_[i], 0);
+  feed_flags_.assign(symbol_count, 0);
+  dirty_.clear();
+  dirty_.reserve(symbol_count);
+}
+
+void SealErosionTracker::SetFeedFlags(uint32_t symbol_id, uint32_t feed_flags) {
+  if (symbol_id >= feed_flags_.size()) return;
+  feed_flags_[symbol_id] = feed_flags & (kSealErosionTrades | kSealErosionCancels);
+}
+
+int32_t SealErosionTracker::MsOfDay_(int32_t t) {
+  return (t / 10000000) * 3600000 + (t / 100000 % 100) * 60000 + (t % 100000);
+}
+
+void SealErosionTracker::Reset_(Symbol* s, int64_t limit_x10000) {
+  ::memset(s, 0, sizeof(*s));
+  s->limit_x10000 = limit_x10000;
+  for (uint32_t i = 0; i < kBuckets; ++i) s->buckets[i].sec = -1;
+}
+
+void SealErosionTracker::OnSnapshot(uint32_t symbol_id, int32_t time_hhmmssmmm) {
+  if (symbol_id >= symbols_.size()) return;
+  const LimitUpState* st = limit_up_ ? limit_up_->state(symbol_id) : nullptr;
+  if (!st || st->limit_x10000 <= 0) return;
+  Symbol* s = &symbols_[symbol_id];
+  const int32_t ms = MsOfDay_(time_hhmmssmmm);
+  const Sample* newest = (s->count != 0) ? &s->samples[(s->head + kSamples - 1) % kSamples] : nullptr;
+  if (st->limit_x10000 != s->limit_x10000 || (newest && ms < newest->ms)) {
+    Reset_(s, st->limit_x10000);
+    newest = nullptr;
+  }
+  if (st->state == kLimitUpNone) return;
+
+  s->active = true;
+  s->sealed = st->state == kLimitUpSealed;
+  s->seal_volume = st->seal_volume;
+  if (time_hhmmssmmm > s->time_hhmmssmmm) s->time_hhmmssmmm = time_hhmmssmmm;
+  if (newest && newest->ms == ms) {
+    s->samples[(s->head + kSamples - 1) % kSamples].seal_volume = st->seal_volume;
+  } else {
+    Sample* slot = &s->samples[s->head];
+    slot->ms = ms;
+    slot->seal_volume = st->seal_volume;
+    s->head = (s->head + 1) % kSamples;
+    if (s->count < kSamples) ++s->count;
+  }
+  MarkDirty_(symbol_id, s);
+}
+
+void SealErosionTracker::OnTrade(uint32_t symbol_id, int32_t time_hhmmssmmm, int64_t price_x10000, int64_t volume) {
+  AddFlow_(symbol_id, time_hhmmssmmm, price_x10000, volume, 0);
+}
+
+void SealErosionTracker::OnBidCancel(uint32_t symbol_id, int32_t time_hhmmssmmm, int64_t price_x10000,
+                                     int64_t volume) {
+  AddFlow_(symbol_id, time_hhmmssmmm, price_x10000, 0, volume);
+}
+
+// Flows are counted as soon as the limit is known (from the first snapshot), so the ticks between
+// the touch and the snapshot that reports it are not lost.
+void SealErosionTracker::AddFlow_(uint32_t symbol_id, int32_t time_hhmmssmmm, int64_t price_x10000, int64_t traded,
+                                  int64_t cancelled) {
+  if (symbol_id >= symbols_.size()) return;
+  Symbol* s = &symbols_[symbol_id];
+  if (s->limit_x10000 <= 0 || price_x10000 != s->limit_x10000) return;
+  if (traded < 0 || cancelled < 0) return;
+
+  const int32_t sec = MsOfDay_(time_hhmmssmmm) / 1000;
+  Bucket* b = &s->buckets[static_cast<uint32_t>(sec) % kBuckets];
+  if (b->sec != sec) {
+    if (b->sec > sec) return;  // older than the ring
+    b->sec = sec;
+    b->traded = 0;
+    b->cancelled = 0;
+  }
+  b->traded += traded;
+  b->cancelled += cancelled;
+  if (time_hhmmssmmm > s->time_hhmmssmmm) s->time_hhmmssmmm = time_hhmmssmmm;
+  if (s->active) MarkDirty_(symbol_id, s);
+}
+
+void SealErosionTracker::MarkDirty_(uint32_t symbol_id, Symbol* s) {
+  if (!s->dirty) {
+    s->dirty = true;
+    dirty_.push_back(symbol_id);
+  }
+}
+
+void SealErosionTracker::Flush() {
+  for (size_t i = 0; i < dirty_.size(); ++i) {
+    Symbol* s = &symbols_[dirty_[i]];
+    Publish_(dirty_[i], *s);
+    s->dirty = false;
+  }
+  dirty_.clear();
+}
+
+void SealErosionTracker::Publish_(uint32_t symbol_id, const Symbol& s) {
+  SealErosion v;
+  ::memset(&v, 0, sizeof(v));
+  v.time_hhmmssmmm = s.time_hhmmssmmm;
+  v.flags = feed_flags_[symbol_id] | (s.sealed ? kSealErosionSealed : 0);
+  v.seal_volume = s.seal_volume;
+  v.seal_amount = s.seal_volume * s.limit_x10000 / 10000;
+
+  const int32_t now_ms = MsOfDay_(s.time_hhmmssmmm);
+  const int32_t now_sec = now_ms / 1000;
+  for (uint32_t w = 0; w < kSealWindows; ++w) {
+    SealWindow* out = &v.w[w];
+    if (s.count != 0) {
+      // Newest sample at or before the horizon start; the oldest kept if the ring is shorter.
+      const int32_t from = now_ms - kSealWindowMs[w];
+      const Sample* base = &s.samples[(s.head + kSamples - s.count) % kSamples];
+      for (uint32_t k = 0; k < s.count; ++k) {
+        const Sample* c = &s.samples[(s.head + kSamples - 1 - k) % kSamples];
+        if (c->ms <= from) {
+          base = c;
+          break;
+        }
+      }
+      out->volume_delta = s.seal_volume - base->seal_volume;
+      out->amount_delta = out->volume_delta * s.limit_x10000 / 10000;
+    }
+    const int32_t secs = kSealWindowMs[w] / 1000;
+    for (int32_t k = 0; k < secs; ++k) {
+      const Bucket& b = s.buckets[static_cast<uint32_t>(now_sec - k) % kBuckets];
+      if (b.sec != now_sec - k) continue;
+      out->traded += b.traded;
+      out->cancelled += b.cancelled;
+    }
+  }
+  writer_->UpdateSealErosion(symbol_id, v);
+}
+
+} // namespace mdg
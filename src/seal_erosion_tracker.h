@@ -0,0 +1,91 @@
+#pragma once
+
+// Gateway-side seal erosion of limit-up symbols (SHM seal_erosion table, see SealErosion).
+//
+// Per symbol, once LimitUpTracker has seen it touch the limit:
+// - a ring of (exchange time, seal volume) samples, one per snapshot; the delta over a horizon is
+//   the seal now minus the newest sample at or before (now - horizon), else the oldest one kept
+// - a ring of one-second buckets of volume executed and bid volume cancelled at the limit, fed by
+//   the tick streams; a horizon sums its last horizon / 1000 seconds
+// Times are exchange times (nTime), so a replayed or delayed feed gives the same windows.
+// The state restarts when the limit price changes or the snapshot time goes back (a new day).
+//
+// Threading: callback thread only; OnSnapshot() must follow LimitUpTracker::OnSnapshot() for the
+// same snapshot.
+
+#include "limit_up_tracker.h"
+#include "shm_writer.h"
+#include "struct_def.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+namespace mdg {
+
+class SealErosionTracker {
+public:
+  static const uint32_t kSamples = 64;  // snapshots remembered per symbol (60s at 1s snapshots)
+  static const uint32_t kBuckets = 64;  // seconds of tick flows remembered per symbol (> longest horizon)
+
+  SealErosionTracker();
+
+  SealErosionTracker(const SealErosionTracker&) = delete;
+  SealErosionTracker& operator=(const SealErosionTracker&) = delete;
+
+  // Allocates per-symbol state (not on the hot path).
+  void Init(ShmWriter* writer, uint32_t symbol_count, const LimitUpTracker* limit_up);
+  bool enabled() const { return writer_ != nullptr; }
+  // kSealErosionTrades / kSealErosionCancels: the tick flows the gateway feeds for this symbol (they
+  // depend on its market), published in SealErosion::flags. Not on the hot path.
+  void SetFeedFlags(uint32_t symbol_id, uint32_t feed_flags);
+
+  void OnSnapshot(uint32_t symbol_id, int32_t time_hhmmssmmm);
+  // One execution / one bid cancel; only those at the symbol's limit price are counted.
+  void OnTrade(uint32_t symbol_id, int32_t time_hhmmssmmm, int64_t price_x10000, int64_t volume);
+  void OnBidCancel(uint32_t symbol_id, int32_t time_hhmmssmmm, int64_t price_x10000, int64_t volume);
+
+  // Publishes every touched-symbol record changed since the last call (once per TDF message).
+  void Flush();
+
+private:
+  struct Sample {
+    int32_t ms;             // ms of day
+    int64_t seal_volume;
+  };
+
+  struct Bucket {
+    int32_t sec;            // second of day, -1 = empty
+    int64_t traded;
+    int64_t cancelled;
+  };
+
+  struct Symbol {
+    int64_t limit_x10000;
+    int64_t seal_volume;
+    int32_t time_hhmmssmmm; // newest snapshot or tick folded in
+    bool active;            // touched the limit: published from now on
+    bool sealed;
+    bool dirty;
+    uint32_t head;          // next sample position
+    uint32_t count;
+    Sample samples[kSamples];
+    Bucket buckets[kBuckets];
+  };
+
+  static int32_t MsOfDay_(int32_t hhmmssmmm);
+  static void Reset_(Symbol* s, int64_t limit_x10000);
+  void AddFlow_(uint32_t symbol_id, int32_t time_hhmmssmmm, int64_t price_x10000, int64_t traded,
+                int64_t cancelled);
+  void MarkDirty_(uint32_t symbol_id, Symbol* s);
+  void Publish_(uint32_t symbol_id, const Symbol& s);
+
+  ShmWriter* writer_;
+  const LimitUpTracker* limit_up_;
+  std::vector<Symbol> symbols_;
+  std::vector<uint32_t> feed_flags_;  // per symbol, kept across Reset_()
+  std::vector<uint32_t> dirty_;  // symbols touched since the last Flush()
+};
+
+} // namespace mdg
@@ -0,0 +1,70 @@
+#pragma once
+
+// C++ wrapper over the mdg_reader C ABI: the trade-side ShmMarketDataApi (see docs/design/trade).
+// Links against mdg_reader only; no TDF dependency.
+//
+//   mdg::ShmMarketDataApi md;
+//   md.connect("/md_gate_shm");
+//   mdg_snapshot_t s;
+//   if (md.get_snapshot("600000.SH", &s) == MDG_OK) { ... }
+//   if (!md.is_connected()) { /* block order entry */ }
+//
+// Symbol ids are cached per name lookup by the caller (find_symbol) and stay valid until epoch() changes.
+
+#include "mdg_reader_c.h"
+
+#include <stdint.h>
+
+namespace mdg {
+
+class ShmMarketDataApi {
+public:
+  ShmMarketDataApi() : r_(nullptr), last_errno_(0) { mdg_reader_config_default(&cfg_); }
+  explicit ShmMarketDataApi(const mdg_reader_config_t& cfg) : r_(nullptr), cfg_(cfg), last_errno_(0) {}
+  ~ShmMarketDataApi() { disconnect(); }
+
+  ShmMarketDataApi(const ShmMarketDataApi&) = delete;
+  ShmMarketDataApi& operator=(const ShmMarketDataApi&) = delete;
+
+  // Open the segment and validate its header. Returns false if missing; see last_errno().
+  bool connect(const char* shm_name) {
+    disconnect();
+    r_ = mdg_reader_open_ex(shm_name, &cfg_, &last_errno_);
+    return r_ != nullptr;
+  }
+  void disconnect() {
+    if (r_) mdg_reader_close(r_);
+    r_ = nullptr;
+  }
+
+  // Mapped and the gateway is healthy now (heartbeat within timeout, md_status OK if required).
+  bool is_connected() const { return r_ && mdg_reader_is_connected(r_) != 0; }
+  uint32_t epoch() const { return mdg_reader_epoch(r_); }
+  int last_errno() const { return last_errno_; }
+
+  uint32_t find_symbol(const char* wind_code) const { return mdg_reader_find_symbol(r_, wind_code); }
+
+  // MDG_OK / MDG_E_* (see mdg_reader_c.h).
+  int get_snapshot(uint32_t symbol_id, mdg_snapshot_t* out, uint64_t* out_update_ns = nullptr) {
+    return mdg_reader_get_snapshot(r_, symbol_id, out, out_update_ns);
+  }
+  int get_snapshot(const char* wind_code, mdg_snapshot_t* out, uint64_t* out_update_ns = nullptr) {
+    return mdg_reader_get_snapshot(r_, find_symbol(wind_code), out, out_update_ns);
+  }
+  int get_limits(uint32_t symbol_id, mdg_limits_t* out) { return mdg_reader_get_limits(r_, symbol_id, out); }
+  int get_limits(const char* wind_code, mdg_limits_t* out) {
+    return mdg_reader_get_limits(r_, find_symbol(wind_code), out);
+  }
+
+  // Once per strategy cycle: liveness/lag/counters into the reader registry.
+  void heartbeat() { mdg_reader_heartbeat(r_); }
+
+  mdg_reader_t* handle() const { return r_; }
+
+private:
+  mdg_reader_t* r_;
+  mdg_reader_config_t cfg_;
+  int last_errno_;
+};
+
+} // namespace mdg
@@ -3,28 +3,94 @@
 #include <errno.h>
 #include <string.h>
 
+#include <chrono>
+
 #if defined(_WIN32)
 #include <windows.h>
 #else
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 #endif
 
 namespace mdg {
 
+namespace {
+
+static uint64_t NowMonotonicNs() {
+#if defined(_WIN32)
+  LARGE_INTEGER freq;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&counter);
+  const double seconds = static_cast<double>(counter.QuadPart) / static_cast<double>(freq.QuadPart);
+  return static_cast<uint64_t>(seconds * 1000000000.0);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+static uint32_t GetPid() {
+#if defined(_WIN32)
+  return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+  return static_cast<uint32_t>(getpid());
+#endif
+}
+
+} // namespace
+
 ShmReader::ShmReader()
     : base_(nullptr),
       bytes_(0),
       header_(nullptr),
       entries_(nullptr),
+      symbol_index_(nullptr),
+      txn_ring_(nullptr),
+      txn_cursor_seq_(0),
+      order_queues_(nullptr),
+      index_dir_(nullptr),
+      index_entries_(nullptr),
+      feed_stats_(nullptr),
+      l3_books_(nullptr),
+      live_trades_(nullptr),
+      sys_events_(nullptr),
+      limit_ups_(nullptr),
+      seal_erosions_(nullptr),
+      history_(nullptr),
+      order_ring_(nullptr),
+      order_cursor_seq_(0),
+      registry_map_(nullptr),
+      registry_map_bytes_(0),
+      slot_(nullptr),
+      mirror_map_(nullptr),
+      mirror_map_bytes_(0),
+      mirror_ctl_(nullptr),
+      mirror_entries_(nullptr),
+      mirror_request_seq_(0),
+      cursor_generation_(0),
+      stale_sample_mask_(kDefaultStaleSampleEvery - 1),
+      wait_policy_(kWaitPolicyDefault),
+      last_read_status_(kReadOk),
 #if defined(_WIN32)
       fd_(nullptr),
 #else
       fd_(-1),
 #endif
-      last_errno_(0) {}
+      last_errno_(0),
+      epoch_(0),
+      mapped_pid_(0),
+      mapped_start_ns_(0),
+      mapped_ino_(0),
+      remap_pending_(false),
+      watch_stop_(false) {
+  ::memset(&stats_, 0, sizeof(stats_));
+  shm_name_[0] = '\0';
+}
 
 ShmReader::~ShmReader() { Close(); }
 
@@ -32,22 +98,43 @@ bool ShmReader::Open(const char* shm_name) {
   Close();
   last_errno_ = 0;
 
-  if (!shm_name || !*shm_name) {
+  if (!shm_name || !*shm_name || ::strlen(shm_name) >= sizeof(shm_name_)) {
     last_errno_ = EINVAL;
     return false;
   }
+  ::memcpy(shm_name_, shm_name, ::strlen(shm_name) + 1);
 
+  cursor_generation_ = 0;
+  txn_cursor_seq_ = 0;
+  order_cursor_seq_ = 0;
+  ::memset(&stats_, 0, sizeof(stats_));
+  last_read_status_ = kReadOk;
+  return OpenMapping_(true);
+}
+
+bool ShmReader::OpenMapping_(bool close_on_map_failure) {
+  const char* shm_name = shm_name_;
 #if defined(_WIN32)
-  HANDLE h = OpenFileMappingA(FILE_MAP_READ, FALSE, shm_name);
+  // Write access is only used for the reader registry view; fall back to read-only.
+  HANDLE h = OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, shm_name);
+  if (!h) h = OpenFileMappingA(FILE_MAP_READ, FALSE, shm_name);
   if (!h) {
     last_errno_ = static_cast<int>(GetLastError());
     return false;
   }
   fd_ = h;
   // Map the entire region (bytes=0 means "entire mapping" on Windows).
-  return MapAndBind_(0, 0);
+  if (!MapAndBind_(0, 0)) {
+    if (close_on_map_failure) Close();
+    return false;
+  }
+  mapped_ino_.store(0, std::memory_order_relaxed);
 #else
-  int fd = shm_open(shm_name, O_RDONLY, 0666);
+  // O_RDWR is only used for the reader registry view; the snapshot mapping stays PROT_READ.
+  int fd = shm_open(shm_name, O_RDWR, 0666);
+  if (fd < 0 && (errno == EACCES || errno == EPERM)) {
+    fd = shm_open(shm_name, O_RDONLY, 0666);
+  }
   if (fd < 0) {
     last_errno_ = errno;
     return false;
@@ -59,12 +146,112 @@ bool ShmReader::Open(const char* shm_name) {
     return false;
   }
   const size_t bytes = static_cast<size_t>(st.st_size);
+  if (bytes < sizeof(ShmHeader)) {
+    // Writer has not sized the segment yet.
+    last_errno_ = EAGAIN;
+    close(fd);
+    return false;
+  }
   fd_ = fd;
-  return MapAndBind_(fd, bytes);
+  if (!MapAndBind_(fd, bytes)) {
+    if (close_on_map_failure) Close();
+    return false;
+  }
+  mapped_ino_.store(static_cast<uint64_t>(st.st_ino), std::memory_order_relaxed);
 #endif
+  ClaimReaderSlot_();
+  if (!mirror_ids_.empty()) ClaimMirror_();
+
+  // Identity the watcher compares against (see WriterChanged_).
+  mapped_pid_.store(header_->writer_pid, std::memory_order_relaxed);
+  mapped_start_ns_.store(header_->writer_start_ns, std::memory_order_relaxed);
+  ++epoch_;
+  return true;
+}
+
+bool ShmReader::Reconnect() {
+  Unmap_();
+  remap_pending_.store(false, std::memory_order_relaxed);
+  if (OpenMapping_(false) && ValidateHeader()) return true;
+
+  // Writer gone, still initializing or incompatible: stay unmapped (name and mirror set kept). The
+  // cleared identity makes the watcher flag the next attempt one interval later, so read calls do not
+  // retry the open on every call.
+  Unmap_();
+  mapped_pid_.store(0, std::memory_order_relaxed);
+  mapped_start_ns_.store(0, std::memory_order_relaxed);
+  mapped_ino_.store(0, std::memory_order_relaxed);
+  return false;
+}
+
+bool ShmReader::CheckWriter() {
+  if (!shm_name_[0]) return false;
+  if (!remap_pending_.load(std::memory_order_relaxed) && base_ && !WriterChanged_()) return true;
+  return Reconnect();
+}
+
+bool ShmReader::StartWatcher(uint32_t interval_ms) {
+  if (!shm_name_[0] || watcher_.joinable()) return false;
+  if (interval_ms == 0) interval_ms = 1;
+  watch_stop_.store(false, std::memory_order_relaxed);
+  watcher_ = std::thread([this, interval_ms]() {
+    while (!watch_stop_.load(std::memory_order_relaxed)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+      if (!remap_pending_.load(std::memory_order_relaxed) && WriterChanged_()) {
+        remap_pending_.store(true, std::memory_order_release);
+      }
+    }
+  });
+  return true;
+}
+
+void ShmReader::StopWatcher() {
+  if (!watcher_.joinable()) return;
+  watch_stop_.store(true, std::memory_order_relaxed);
+  watcher_.join();
+}
+
+bool ShmReader::WriterChanged_() const {
+  // Runs on the watcher thread: never touches the caller's mapping, probes the segment directly.
+  ShmHeader h;
+#if defined(_WIN32)
+  HANDLE fm = OpenFileMappingA(FILE_MAP_READ, FALSE, shm_name_);
+  if (!fm) return false;  // gateway gone: keep the old mapping, heartbeat shows it is stale
+  const void* p = MapViewOfFile(fm, FILE_MAP_READ, 0, 0, sizeof(ShmHeader));
+  if (!p) {
+    CloseHandle(fm);
+    return false;
+  }
+  ::memcpy(&h, p, sizeof(h));
+  UnmapViewOfFile(p);
+  CloseHandle(fm);
+#else
+  int fd = shm_open(shm_name_, O_RDONLY, 0666);
+  if (fd < 0) return false;  // gateway gone: keep the old mapping, heartbeat shows it is stale
+  struct stat st;
+  const bool ok = fstat(fd, &st) == 0 &&
+                  pread(fd, &h, sizeof(h), 0) == static_cast<ssize_t>(sizeof(h));
+  close(fd);
+  if (!ok) return false;
+  if (static_cast<uint64_t>(st.st_ino) != mapped_ino_.load(std::memory_order_relaxed)) return true;
+#endif
+  // Same object re-initialized in place (gateway restarted without unlink).
+  if (h.writer_start_ns == 0) return false;  // writer mid-init; check again next round
+  return h.writer_pid != mapped_pid_.load(std::memory_order_relaxed) ||
+         h.writer_start_ns != mapped_start_ns_.load(std::memory_order_relaxed);
 }
 
 void ShmReader::Close() {
+  StopWatcher();
+  Unmap_();
+  mirror_ids_.clear();
+  shm_name_[0] = '\0';
+  remap_pending_.store(false, std::memory_order_relaxed);
+}
+
+void ShmReader::Unmap_() {
+  ReleaseMirror_();
+  ReleaseReaderSlot_();
   if (base_) {
 #if defined(_WIN32)
     UnmapViewOfFile(base_);
@@ -76,6 +263,19 @@ void ShmReader::Close() {
   bytes_ = 0;
   header_ = nullptr;
   entries_ = nullptr;
+  symbol_index_ = nullptr;
+  txn_ring_ = nullptr;
+  order_ring_ = nullptr;
+  order_queues_ = nullptr;
+  index_dir_ = nullptr;
+  index_entries_ = nullptr;
+  feed_stats_ = nullptr;
+  l3_books_ = nullptr;
+  live_trades_ = nullptr;
+  sys_events_ = nullptr;
+  limit_ups_ = nullptr;
+  seal_erosions_ = nullptr;
+  history_ = nullptr;
 
 #if defined(_WIN32)
   if (fd_) {
@@ -95,7 +295,7 @@ bool ShmReader::ValidateHeader() const {
 
   const char kMagic[8] = {'M','D','G','A','T','E','1','\0'};
   if (::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0) return false;
-  if (header_->abi_version != 1) return false;
+  if (header_->abi_version != kShmAbiVersion) return false;
   if (header_->endian != 1) return false;
   if (header_->header_bytes < sizeof(ShmHeader)) return false;
   if (header_->snapshot_entry_bytes != sizeof(SnapshotEntry)) return false;
@@ -122,30 +322,924 @@ bool ShmReader::ValidateHeader() const {
     if (header_->symbol_dir_bytes < min_bytes) return false;
     if (header_->snapshot_offset < dir_end) return false;
   }
+
+  // Optional symbol index validation.
+  if (header_->symbol_index_offset != 0 || header_->symbol_index_bytes != 0) {
+    const uint32_t cap = header_->symbol_index_capacity;
+    if (cap == 0 || (cap & (cap - 1)) != 0) return false;
+    if (header_->symbol_index_offset < header_->header_bytes) return false;
+    if (header_->symbol_index_offset + header_->symbol_index_bytes > total_bytes) return false;
+    if (header_->symbol_index_bytes < static_cast<uint64_t>(cap) * sizeof(SymbolIndexSlot)) return false;
+  }
+
+  // Optional reader registry validation.
+  if (header_->reader_registry_offset != 0 || header_->reader_registry_bytes != 0) {
+    if ((header_->reader_registry_offset % kShmRegionAlignBytes) != 0) return false;
+    if (header_->reader_registry_offset < snapshot_end) return false;
+    if (header_->reader_registry_offset + header_->reader_registry_bytes > total_bytes) return false;
+    if (header_->reader_slot_bytes != sizeof(ReaderSlot)) return false;
+    const uint64_t min_bytes = static_cast<uint64_t>(header_->reader_capacity) * sizeof(ReaderSlot);
+    if (header_->reader_registry_bytes < min_bytes) return false;
+  }
+
+  // Optional transaction ring.
+  if (header_->flags & kShmFlagTransactionRing) {
+    const uint32_t cap = header_->event_capacity;
+    if (cap == 0 || (cap & (cap - 1)) != 0) return false;
+    if (header_->event_slot_bytes != sizeof(TransactionSlot)) return false;
+    if (header_->event_ring_offset < snapshot_end) return false;
+    if (header_->event_ring_offset + header_->event_ring_bytes > total_bytes) return false;
+    if (header_->event_ring_bytes < static_cast<uint64_t>(cap) * sizeof(TransactionSlot)) return false;
+  }
+
+  // Optional order ring.
+  if (header_->flags & kShmFlagOrderRing) {
+    const uint32_t cap = header_->order_capacity;
+    if (cap == 0 || (cap & (cap - 1)) != 0) return false;
+    if (header_->order_slot_bytes != sizeof(OrderSlot)) return false;
+    if (header_->order_ring_offset < snapshot_end) return false;
+    if (header_->order_ring_offset + header_->order_ring_bytes > total_bytes) return false;
+    if (header_->order_ring_bytes < static_cast<uint64_t>(cap) * sizeof(OrderSlot)) return false;
+  }
+
+  // Optional order queue table.
+  if (header_->flags & kShmFlagOrderQueue) {
+    if (header_->order_queue_entry_bytes != sizeof(OrderQueueEntry)) return false;
+    if (header_->order_queue_offset < snapshot_end) return false;
+    if (header_->order_queue_offset + header_->order_queue_bytes > total_bytes) return false;
+    if (header_->order_queue_bytes < static_cast<uint64_t>(header_->symbol_count) * 2 * sizeof(OrderQueueEntry)) {
+      return false;
+    }
+  }
+
+  // Optional L3 book table.
+  if (header_->flags & kShmFlagL3Book) {
+    if (header_->l3_book_entry_bytes != sizeof(L3BookEntry)) return false;
+    if (header_->l3_book_levels != kL3BookLevels) return false;
+    if (header_->l3_book_offset < snapshot_end) return false;
+    if (header_->l3_book_offset + header_->l3_book_bytes > total_bytes) return false;
+    if (header_->l3_book_bytes < static_cast<uint64_t>(header_->symbol_count) * sizeof(L3BookEntry)) return false;
+  }
+
+  // Optional live trade overlay.
+  if (header_->flags & kShmFlagLiveTrade) {
+    if (header_->live_trade_entry_bytes != sizeof(LiveTradeEntry)) return false;
+    if (header_->live_trade_offset < snapshot_end) return false;
+    if (header_->live_trade_offset + header_->live_trade_bytes > total_bytes) return false;
+    if (header_->live_trade_bytes < static_cast<uint64_t>(header_->symbol_count) * sizeof(LiveTradeEntry)) {
+      return false;
+    }
+  }
+
+  // Optional snapshot history.
+  if (header_->flags & kShmFlagHistory) {
+    const uint32_t depth = header_->history_depth;
+    if (depth == 0 || depth > kMaxHistoryDepth || (depth & (depth - 1)) != 0) return false;
+    if (header_->history_stride_bytes != sizeof(HistoryHead) + static_cast<uint64_t>(depth) * sizeof(HistorySlot)) {
+      return false;
+    }
+    if (header_->history_offset < snapshot_end) return false;
+    if (header_->history_offset + header_->history_bytes > total_bytes) return false;
+    if (header_->history_bytes < static_cast<uint64_t>(header_->symbol_count) * header_->history_stride_bytes) {
+      return false;
+    }
+  }
+
+  // Optional limit-up table.
+  if (header_->flags & kShmFlagLimitUp) {
+    if (header_->limit_up_entry_bytes != sizeof(LimitUpEntry)) return false;
+    if (header_->limit_up_offset < snapshot_end) return false;
+    if (header_->limit_up_offset + header_->limit_up_bytes > total_bytes) return false;
+    if (header_->limit_up_bytes < static_cast<uint64_t>(header_->symbol_count) * sizeof(LimitUpEntry)) return false;
+  }
+
+  // Optional seal erosion table.
+  if (header_->flags & kShmFlagSealErosion) {
+    if (header_->seal_erosion_entry_bytes != sizeof(SealErosionEntry)) return false;
+    if (header_->seal_erosion_windows != kSealWindows) return false;
+    if (header_->seal_erosion_offset < snapshot_end) return false;
+    if (header_->seal_erosion_offset + header_->seal_erosion_bytes > total_bytes) return false;
+    if (header_->seal_erosion_bytes < static_cast<uint64_t>(header_->symbol_count) * sizeof(SealErosionEntry)) {
+      return false;
+    }
+  }
+
+  // Optional system event ring.
+  if (header_->flags & kShmFlagSystemEvents) {
+    const uint32_t cap = header_->sys_event_capacity;
+    if (cap == 0 || (cap & (cap - 1)) != 0) return false;
+    if (header_->sys_event_offset < snapshot_end) return false;
+    if (header_->sys_event_offset + header_->sys_event_bytes > total_bytes) return false;
+    if (header_->sys_event_bytes < static_cast<uint64_t>(cap) * sizeof(SystemEventSlot)) return false;
+  }
+
+  // Optional feed integrity stats.
+  if (header_->flags & kShmFlagFeedIntegrity) {
+    const uint32_t cap = header_->feed_stats_capacity;
+    if (cap == 0 || load_u32_acquire(&header_->feed_stats_count) > cap) return false;
+    if (header_->feed_stats_offset < snapshot_end) return false;
+    if (header_->feed_stats_bytes < static_cast<uint64_t>(cap) * sizeof(FeedStreamStats)) return false;
+    if (header_->feed_stats_offset + header_->feed_stats_bytes > total_bytes) return false;
+  }
+
+  // Optional index table.
+  if (header_->flags & kShmFlagIndexTable) {
+    const uint32_t cap = header_->index_capacity;
+    if (cap == 0 || cap > kMaxIndices) return false;
+    if (load_u32_acquire(&header_->index_count) > cap) return false;
+    if (header_->index_dir_offset < snapshot_end) return false;
+    if (header_->index_dir_bytes < static_cast<uint64_t>(cap) * kWindCodeBytes) return false;
+    if (header_->index_dir_offset + header_->index_dir_bytes > total_bytes) return false;
+    if (header_->index_entries_offset < header_->index_dir_offset + header_->index_dir_bytes) return false;
+    if (header_->index_entries_bytes < static_cast<uint64_t>(cap) * sizeof(IndexEntry)) return false;
+    if (header_->index_entries_offset + header_->index_entries_bytes > total_bytes) return false;
+  }
+
+  // Optional mirror regions.
+  if (header_->mirror_ctl_offset != 0 || header_->mirror_entries_offset != 0) {
+    if ((header_->mirror_ctl_offset % kShmRegionAlignBytes) != 0) return false;
+    if (header_->mirror_ctl_offset < snapshot_end) return false;
+    if (header_->mirror_ctl_offset + header_->mirror_ctl_bytes > total_bytes) return false;
+    if (header_->mirror_ctl_bytes < static_cast<uint64_t>(header_->mirror_capacity) * sizeof(MirrorControl)) {
+      return false;
+    }
+    const uint64_t min_bytes = static_cast<uint64_t>(header_->mirror_capacity) * header_->mirror_max_symbols *
+                               sizeof(SnapshotEntry);
+    if (header_->mirror_entries_bytes < min_bytes) return false;
+    if (header_->mirror_entries_offset + header_->mirror_entries_bytes > total_bytes) return false;
+  }
   return true;
 }
 
+uint32_t ShmReader::FindSymbol(const char* wind_code) const {
+  if (!header_) return kInvalidSymbolId;
+  uint32_t key = 0;
+  char canon[kWindCodeBytes];
+  if (!parse_wind_code_key(wind_code, &key, canon)) return kInvalidSymbolId;
+
+  if (symbol_index_) {
+    const uint32_t id = symbol_index_find(symbol_index_, header_->symbol_index_capacity, key);
+    return (id < header_->symbol_count) ? id : kInvalidSymbolId;
+  }
+
+  // Old segments without an index: linear scan of symbol_dir.
+  if (header_->symbol_dir_offset == 0 || header_->symbol_dir_bytes == 0) return kInvalidSymbolId;
+  const char* dir = reinterpret_cast<const char*>(base_) + static_cast<size_t>(header_->symbol_dir_offset);
+  for (uint32_t i = 0; i < header_->symbol_count; ++i) {
+    if (::strncmp(dir + static_cast<size_t>(i) * kSymbolDirEntryBytes, canon, kSymbolDirEntryBytes) == 0) return i;
+  }
+  return kInvalidSymbolId;
+}
+
+bool ShmReader::WaitSlow_(const ReadWaitPolicy& policy, uint32_t step) const {
+  if (step < policy.yield_count) {
+    std::this_thread::yield();
+    return true;
+  }
+  step -= policy.yield_count;
+  if (step < policy.sleep_count) {
+    std::this_thread::sleep_for(std::chrono::microseconds(policy.sleep_us));
+    return true;
+  }
+  return false;
+}
+
+ReadStatus ShmReader::ReadEntry_(const SnapshotEntry* e, MarketData320* out, uint32_t* out_seq_even,
+                                 const ReadWaitPolicy& policy) {
+  // "moved" separates a busy writer (seq keeps advancing) from one parked mid-write (same odd seq).
+  const uint32_t first = load_u32_acquire(&e->seq);
+  bool moved = false;
+  for (uint32_t step = 0;; ++step) {
+    if (seqlock_read_once(e, out, out_seq_even)) {
+      NoteRead_(e, step);
+      return kReadOk;
+    }
+    if (!moved && load_u32_relaxed(&e->seq) != first) moved = true;
+    if (!WaitStep_(policy, step)) {
+      const ReadStatus st = moved ? kReadRetryExceeded : kReadWriterStuck;
+      NoteFailure_(st, step);
+      return st;
+    }
+  }
+}
+
+template <typename Copy>
+ReadStatus ShmReader::ReadSeqlocked_(const AtomicU32* seq, Copy copy) {
+  const uint32_t first = load_u32_acquire(seq);
+  bool moved = false;
+  for (uint32_t step = 0;; ++step) {
+    const uint32_t s1 = load_u32_acquire(seq);
+    if ((s1 & 1U) == 0) {
+      compiler_barrier();
+      copy();
+      compiler_barrier();
+      if (load_u32_acquire(seq) == s1) {
+        NoteRead_(nullptr, step);
+        return kReadOk;
+      }
+    }
+    if (s1 != first || (s1 & 1U) == 0) moved = true;  // even s1 here means the re-check differed
+    if (!WaitStep_(wait_policy_, step)) {
+      const ReadStatus st = moved ? kReadRetryExceeded : kReadWriterStuck;
+      NoteFailure_(st, step);
+      return st;
+    }
+  }
+}
+
 bool ShmReader::ReadSnapshot(uint32_t symbol_id, MarketData320* out, uint32_t* out_seq_even) {
-  return ReadSnapshotSpin(symbol_id, out, 200, out_seq_even);
+  MaybeRemap_();
+  if (!entries_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || symbol_id >= header_->symbol_count) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+  last_read_status_ = ReadEntry_(&entries_[symbol_id], out, out_seq_even, wait_policy_);
+  return last_read_status_ == kReadOk;
+}
+
+bool ShmReader::ReadSnapshotLive(uint32_t symbol_id, MarketData320* out, uint32_t* out_seq_even, bool* out_live) {
+  if (out_live) *out_live = false;
+  if (!ReadSnapshot(symbol_id, out, out_seq_even)) return false;
+  if (!live_trades_) return true;
+
+  LiveTrade lt;
+  if (!ReadLiveTrade(symbol_id, &lt)) {
+    last_read_status_ = kReadOk;  // the snapshot itself is good
+    return true;
+  }
+  MarketDataPayloadV1* p = reinterpret_cast<MarketDataPayloadV1*>(out->bytes);
+  if (lt.last_update_ns == 0 || lt.volume < p->volume || lt.time_hhmmssmmm < p->time_hhmmssmmm) return true;
+  if (lt.volume == p->volume && lt.time_hhmmssmmm == p->time_hhmmssmmm) return true;
+
+  p->last_x10000 = lt.last_x10000;
+  p->volume = lt.volume;
+  p->turnover = lt.turnover;
+  p->time_hhmmssmmm = lt.time_hhmmssmmm;
+  if (lt.last_x10000 > p->high_x10000) p->high_x10000 = lt.last_x10000;
+  if (lt.last_x10000 > 0 && (p->low_x10000 <= 0 || lt.last_x10000 < p->low_x10000)) p->low_x10000 = lt.last_x10000;
+  if (out_live) *out_live = true;
+  return true;
+}
+
+bool ShmReader::ReadLimitUp(uint32_t symbol_id, LimitUpState* out) {
+  MaybeRemap_();
+  if (!limit_ups_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || symbol_id >= header_->symbol_count) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+
+  const LimitUpEntry* e = &limit_ups_[symbol_id];
+  last_read_status_ = ReadSeqlocked_(&e->seq, [&]() {
+    *out = e->v;
+  });
+  return last_read_status_ == kReadOk;
+}
+
+bool ShmReader::ReadSealErosion(uint32_t symbol_id, SealErosion* out) {
+  MaybeRemap_();
+  if (!seal_erosions_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || symbol_id >= header_->symbol_count) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+
+  const SealErosionEntry* e = &seal_erosions_[symbol_id];
+  last_read_status_ = ReadSeqlocked_(&e->seq, [&]() {
+    *out = e->v;
+  });
+  return last_read_status_ == kReadOk;
+}
+
+bool ShmReader::ReadLiveTrade(uint32_t symbol_id, LiveTrade* out) {
+  MaybeRemap_();
+  if (!live_trades_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || symbol_id >= header_->symbol_count) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+
+  const LiveTradeEntry* e = &live_trades_[symbol_id];
+  last_read_status_ = ReadSeqlocked_(&e->seq, [&]() {
+    *out = e->v;
+  });
+  return last_read_status_ == kReadOk;
 }
 
 bool ShmReader::ReadSnapshotSpin(uint32_t symbol_id, MarketData320* out, uint32_t max_spins, uint32_t* out_seq_even) {
-  if (!entries_ || !header_ || !out) return false;
-  if (symbol_id >= header_->symbol_count) return false;
+  MaybeRemap_();
+  if (!entries_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || symbol_id >= header_->symbol_count) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+  // max_spins attempts: the first plus max_spins - 1 pause-spins.
+  const ReadWaitPolicy spin_only = {max_spins > 0 ? max_spins - 1 : 0, 0, 0, 0};
+  last_read_status_ = ReadEntry_(&entries_[symbol_id], out, out_seq_even, spin_only);
+  return last_read_status_ == kReadOk;
+}
+
+ReadStatus ShmReader::ReadIfChanged(uint32_t symbol_id, uint32_t* last_seq, MarketData320* out) {
+  MaybeRemap_();
+  if (!entries_ || !header_) return kReadNotMapped;
+  if (!last_seq || !out || symbol_id >= header_->symbol_count) return kReadInvalidArg;
 
+  // An even seq equal to the caller's means no write completed or started since its last read.
   const SnapshotEntry* e = &entries_[symbol_id];
-  for (uint32_t i = 0; i < max_spins; ++i) {
-    if (seqlock_read_once(e, out, out_seq_even)) return true;
+  const uint32_t seq = load_u32_acquire(&e->seq);
+  if (seq == *last_seq) return kReadUnchanged;
+
+  return ReadEntry_(e, out, last_seq, wait_policy_);
+}
+
+ReadStatus ShmReader::ReadCut(const uint32_t* ids, size_t n, MarketData320* out, uint64_t* out_generation,
+                              uint32_t max_attempts) {
+  MaybeRemap_();
+  if (!entries_ || !header_) return kReadNotMapped;
+  if (!out) return kReadInvalidArg;
+  if ((header_->flags & kShmFlagPublishGeneration) == 0) return kReadInvalidArg;
+  if (ids) {
+    for (size_t i = 0; i < n; ++i) {
+      if (ids[i] >= header_->symbol_count) return kReadInvalidArg;
+    }
+  }
+
+  uint32_t attempt = 0;
+  uint32_t step = 0;         // wait steps spent on the batch in flight
+  uint64_t wait_begin = 0;   // publish_begin when that wait started
+  while (attempt < max_attempts) {
+    const uint64_t end1 = load_u64_acquire(&header_->publish_end);
+    const uint64_t begin1 = load_u64_acquire(&header_->publish_begin);
+    if (begin1 != end1) {
+      // Batch in flight (a burst can bracket for ms): wait under the policy instead of spending attempts.
+      if (step == 0) wait_begin = begin1;
+      if (!WaitStep_(wait_policy_, step++)) {
+        const bool stuck = load_u64_acquire(&header_->publish_begin) == wait_begin &&
+                           load_u64_acquire(&header_->publish_end) == end1;
+        const ReadStatus st = stuck ? kReadWriterStuck : kReadRetryExceeded;
+        NoteFailure_(st, attempt);
+        return st;
+      }
+      continue;
+    }
+    step = 0;
+
+    compiler_barrier();
+    const bool copied = CopyCut_(ids, n, out);
+    compiler_barrier();
+
+    // No batch started since begin1 => nothing we copied was written after generation end1.
+    const uint64_t begin2 = load_u64_acquire(&header_->publish_begin);
+    if (copied && begin2 == begin1) {
+      if (out_generation) *out_generation = end1;
+      cursor_generation_ = end1;
+      NoteRead_(nullptr, attempt);
+      return kReadOk;
+    }
+    ++attempt;
+  }
+  NoteFailure_(kReadRetryExceeded, max_attempts);
+  return kReadRetryExceeded;
+}
+
+bool ShmReader::CopyCut_(const uint32_t* ids, size_t n, MarketData320* out) {
+  // Entry seqs still need to be even: a write outside any batch bracket must not be torn.
+  if (!ids) {
+    const uint32_t count = header_->symbol_count;
+    for (uint32_t i = 0; i < count; ++i) {
+      if (i + kBatchPrefetchAhead < count) prefetch_snapshot_entry(&entries_[i + kBatchPrefetchAhead]);
+      if (!seqlock_read_once(&entries_[i], &out[i], nullptr)) return false;
+    }
+    return true;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (i + kBatchPrefetchAhead < n) prefetch_snapshot_entry(&entries_[ids[i + kBatchPrefetchAhead]]);
+    if (!seqlock_read_once(&entries_[ids[i]], &out[i], nullptr)) return false;
+  }
+  return true;
+}
+
+size_t ShmReader::ReadSnapshots(const uint32_t* ids, size_t n, MarketData320* out, uint32_t* seqs) {
+  MaybeRemap_();
+  if (!entries_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return 0;
+  }
+  if (!ids || !out || !seqs) {
+    last_read_status_ = kReadInvalidArg;
+    return 0;
+  }
+  const uint32_t count = header_->symbol_count;
+  last_read_status_ = kReadOk;
+
+  // Pass 1: one attempt each; the prefetch window keeps several entries in flight.
+  const size_t warm = (n < kBatchPrefetchAhead) ? n : kBatchPrefetchAhead;
+  for (size_t i = 0; i < warm; ++i) {
+    if (ids[i] < count) prefetch_snapshot_entry(&entries_[ids[i]]);
+  }
+  size_t ok = 0;
+  size_t torn = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (i + kBatchPrefetchAhead < n) {
+      const uint32_t ahead = ids[i + kBatchPrefetchAhead];
+      if (ahead < count) prefetch_snapshot_entry(&entries_[ahead]);
+    }
+    seqs[i] = kSeqInvalid;
+    const uint32_t id = ids[i];
+    if (id >= count) {
+      last_read_status_ = kReadInvalidArg;
+      continue;
+    }
+    if (seqlock_read_once(&entries_[id], &out[i], &seqs[i])) {
+      NoteRead_(&entries_[id], 0);
+      ++ok;
+    } else {
+      ++torn;
+    }
+  }
+
+  // Pass 2: only the torn ones (their writer had the entry odd during pass 1).
+  if (torn != 0) {
+    for (size_t i = 0; i < n; ++i) {
+      if (seqs[i] != kSeqInvalid || ids[i] >= count) continue;
+      const ReadStatus st = ReadEntry_(&entries_[ids[i]], &out[i], &seqs[i], wait_policy_);
+      if (st == kReadOk) {
+        ++ok;
+      } else {
+        seqs[i] = kSeqInvalid;
+        last_read_status_ = st;
+      }
+    }
+  }
+
+  return ok;
+}
+
+void ShmReader::SetStaleSampleEvery(uint32_t n) {
+  if (n == 0) {
+    stale_sample_mask_ = ~0ULL;
+    return;
+  }
+  uint64_t every = 1;
+  while (every < n) every <<= 1;
+  stale_sample_mask_ = every - 1;
+}
+
+void ShmReader::NoteStaleness_(const SnapshotEntry* e) {
+  // Plain read outside the seqlock: the value may be one update newer than the copy, fine for stats.
+  const uint64_t updated = e->last_update_ns;
+  if (updated == 0) return;  // never written
+  const uint64_t now = NowMonotonicNs();
+  const uint64_t stale = (now > updated) ? (now - updated) : 0;
+  ++stats_.stale_samples;
+  ++stats_.stale_hist[reader_stale_bucket(stale)];
+  if (stale > stats_.stale_max_ns) stats_.stale_max_ns = stale;
+}
+
+void ShmReader::Heartbeat(uint64_t now_ns) {
+  if (!slot_ || !header_) return;
+  store_u64_relaxed(&slot_->reads_ok, stats_.reads_ok);
+  store_u64_relaxed(&slot_->read_retries, stats_.read_retries);
+  store_u64_relaxed(&slot_->read_failures, stats_.read_failures);
+  store_u64_relaxed(&slot_->torn_reads, stats_.torn_reads);
+  store_u64_relaxed(&slot_->retry_exceeded, stats_.retry_exceeded);
+  store_u64_relaxed(&slot_->writer_stuck, stats_.writer_stuck);
+  store_u64_relaxed(&slot_->stale_samples, stats_.stale_samples);
+  store_u64_relaxed(&slot_->stale_max_ns, stats_.stale_max_ns);
+  for (uint32_t i = 0; i < kReaderRetryBuckets; ++i) store_u64_relaxed(&slot_->retry_hist[i], stats_.retry_hist[i]);
+  for (uint32_t i = 0; i < kReaderStaleBuckets; ++i) store_u64_relaxed(&slot_->stale_hist[i], stats_.stale_hist[i]);
+  store_u64_relaxed(&slot_->cursor_md_ns, load_u64_acquire(&header_->last_md_ns));
+  store_u64_relaxed(&slot_->cursor_generation, cursor_generation_);
+  store_u64_relaxed(&slot_->cursor_txn_seq, txn_cursor_seq_);
+  store_u64_relaxed(&slot_->cursor_order_seq, order_cursor_seq_);
+  store_u64_release(&slot_->heartbeat_ns, now_ns);
+}
+
+void ShmReader::ClaimReaderSlot_() {
+  if (!header_ || (header_->flags & kShmFlagReaderRegistry) == 0) return;
+
+  const uint64_t off = header_->reader_registry_offset;
+  const uint64_t reg_bytes = header_->reader_registry_bytes;
+  if (off == 0 || reg_bytes == 0) return;
+  if ((off % kShmRegionAlignBytes) != 0) return;
+  if (off + reg_bytes > static_cast<uint64_t>(bytes_)) return;
+  if (header_->reader_slot_bytes != sizeof(ReaderSlot)) return;
+  const uint32_t capacity = header_->reader_capacity;
+  if (static_cast<uint64_t>(capacity) * sizeof(ReaderSlot) > reg_bytes) return;
+
+  void* p = MapWritable_(off, reg_bytes);
+  if (!p) return;
+  registry_map_ = p;
+  registry_map_bytes_ = static_cast<size_t>(reg_bytes);
+
+  ReaderSlot* slots = reinterpret_cast<ReaderSlot*>(p);
+  const uint32_t pid = GetPid();
+  for (uint32_t i = 0; i < capacity; ++i) {
+    if (!cas_u32_acq_rel(&slots[i].owner_pid, 0, pid)) continue;
+    ReaderSlot* s = &slots[i];
+    const uint64_t now = NowMonotonicNs();
+    s->attach_ns = now;
+    reader_slot_clear_counters(s);
+    store_u64_relaxed(&s->cursor_md_ns, load_u64_acquire(&header_->last_md_ns));
+    store_u64_relaxed(&s->cursor_generation, 0);
+    store_u64_relaxed(&s->cursor_txn_seq, 0);
+    store_u64_relaxed(&s->cursor_order_seq, 0);
+    store_u64_release(&s->heartbeat_ns, now);
+    slot_ = s;
+    return;
+  }
+
+  // Registry full: keep reading without a slot.
+  ReleaseReaderSlot_();
+}
+
+void ShmReader::ReleaseReaderSlot_() {
+  if (slot_) {
+    store_u64_relaxed(&slot_->heartbeat_ns, 0);
+    store_u64_relaxed(&slot_->cursor_md_ns, 0);
+    store_u32_release(&slot_->owner_pid, 0);
+    slot_ = nullptr;
   }
+  if (registry_map_) UnmapWritable_(registry_map_, registry_map_bytes_);
+  registry_map_ = nullptr;
+  registry_map_bytes_ = 0;
+}
+
+void* ShmReader::MapWritable_(uint64_t offset, uint64_t bytes) {
+  // offset must be kShmRegionAlignBytes-aligned (checked by callers).
+#if defined(_WIN32)
+  void* p = MapViewOfFile(fd_, FILE_MAP_WRITE, static_cast<DWORD>((offset >> 32) & 0xffffffffu),
+                          static_cast<DWORD>(offset & 0xffffffffu), static_cast<SIZE_T>(bytes));
+  return p;
+#else
+  void* p = mmap(nullptr, static_cast<size_t>(bytes), PROT_READ | PROT_WRITE, MAP_SHARED, fd_,
+                 static_cast<off_t>(offset));
+  return (p == MAP_FAILED) ? nullptr : p;  // e.g. fd opened O_RDONLY
+#endif
+}
+
+void ShmReader::UnmapWritable_(void* p, size_t bytes) {
+#if defined(_WIN32)
+  (void)bytes;
+  UnmapViewOfFile(p);
+#else
+  munmap(p, bytes);
+#endif
+}
+
+bool ShmReader::RegisterMirror(const uint32_t* ids, uint32_t n) {
+  if (!ids || n == 0 || n > kMirrorMaxSymbols) {
+    last_errno_ = EINVAL;
+    return false;
+  }
+  mirror_ids_.assign(ids, ids + n);
+  if (ClaimMirror_()) return true;
+  mirror_ids_.clear();
   return false;
 }
 
+void ShmReader::ReleaseMirror() {
+  ReleaseMirror_();
+  mirror_ids_.clear();
+}
+
+bool ShmReader::ClaimMirror_() {
+  if (!header_ || (header_->flags & kShmFlagMirrors) == 0) {
+    last_errno_ = ENOTSUP;
+    return false;
+  }
+  const uint64_t off = header_->mirror_ctl_offset;
+  const uint64_t ctl_bytes = header_->mirror_ctl_bytes;
+  const uint32_t capacity = header_->mirror_capacity;
+  if (off == 0 || (off % kShmRegionAlignBytes) != 0 || off + ctl_bytes > static_cast<uint64_t>(bytes_) ||
+      header_->mirror_max_symbols != kMirrorMaxSymbols ||
+      static_cast<uint64_t>(capacity) * sizeof(MirrorControl) > ctl_bytes) {
+    last_errno_ = EINVAL;
+    return false;
+  }
+
+  // Keep the current mirror when replacing the set.
+  if (!mirror_ctl_) {
+    void* p = MapWritable_(off, ctl_bytes);
+    if (!p) {
+      last_errno_ = EACCES;
+      return false;
+    }
+    MirrorControl* ctls = reinterpret_cast<MirrorControl*>(p);
+    const uint32_t pid = GetPid();
+    uint32_t i = 0;
+    for (; i < capacity; ++i) {
+      if (cas_u32_acq_rel(&ctls[i].owner_pid, 0, pid)) break;
+    }
+    if (i == capacity) {
+      UnmapWritable_(p, static_cast<size_t>(ctl_bytes));
+      last_errno_ = EBUSY;
+      return false;
+    }
+    mirror_map_ = p;
+    mirror_map_bytes_ = static_cast<size_t>(ctl_bytes);
+    mirror_ctl_ = &ctls[i];
+    mirror_entries_ = ::mdg::mirror_entries(base_, header_, i);
+  }
+
+  const uint32_t n = static_cast<uint32_t>(mirror_ids_.size());
+  mirror_ctl_->count = n;
+  ::memcpy(mirror_ctl_->ids, mirror_ids_.data(), static_cast<size_t>(n) * sizeof(uint32_t));
+  // Never publish 0 (the gateway treats request_seq 0 as "nothing requested").
+  uint32_t seq = load_u32_relaxed(&mirror_ctl_->request_seq) + 1;
+  if (seq == 0) seq = 1;
+  store_u32_release(&mirror_ctl_->request_seq, seq);
+  mirror_request_seq_ = seq;
+  return true;
+}
+
+void ShmReader::ReleaseMirror_() {
+  if (mirror_ctl_) store_u32_release(&mirror_ctl_->owner_pid, 0);
+  if (mirror_map_) UnmapWritable_(mirror_map_, mirror_map_bytes_);
+  mirror_map_ = nullptr;
+  mirror_map_bytes_ = 0;
+  mirror_ctl_ = nullptr;
+  mirror_entries_ = nullptr;
+  mirror_request_seq_ = 0;
+}
+
+bool ShmReader::ReadMirror(uint32_t pos, MarketData320* out, uint32_t* out_seq_even) {
+  MaybeRemap_();
+  if (!mirror_entries_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || pos >= mirror_ids_.size()) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+  if (!mirror_ready()) {
+    last_read_status_ = kReadNotReady;
+    return false;
+  }
+  last_read_status_ = ReadEntry_(&mirror_entries_[pos], out, out_seq_even, wait_policy_);
+  return last_read_status_ == kReadOk;
+}
+
+size_t ShmReader::ReadMirrorAll(MarketData320* out, uint32_t* seqs) {
+  MaybeRemap_();
+  if (!mirror_entries_) {
+    last_read_status_ = kReadNotMapped;
+    return 0;
+  }
+  if (!out || !seqs) {
+    last_read_status_ = kReadInvalidArg;
+    return 0;
+  }
+  if (!mirror_ready()) {
+    last_read_status_ = kReadNotReady;
+    return 0;
+  }
+  // Sequential over contiguous entries: the hardware prefetcher streams them, no explicit prefetch.
+  last_read_status_ = kReadOk;
+  size_t ok = 0;
+  const size_t n = mirror_ids_.size();
+  for (size_t i = 0; i < n; ++i) {
+    const ReadStatus st = ReadEntry_(&mirror_entries_[i], &out[i], &seqs[i], wait_policy_);
+    if (st == kReadOk) {
+      ++ok;
+    } else {
+      seqs[i] = kSeqInvalid;
+      last_read_status_ = st;
+    }
+  }
+  return ok;
+}
+
+void ShmReader::SeekRing_(uint32_t capacity, const AtomicU64* write_seq, RingCursor* c, bool from_oldest) const {
+  ring_seek(capacity, write_seq, c, from_oldest);
+  c->epoch = epoch_;
+}
+
+template <typename Slot, typename Record>
+size_t ShmReader::PollRing_(const Slot* ring, uint32_t capacity, const AtomicU64* write_seq, RingCursor* c,
+                            Record* out, size_t max) {
+  if (c->epoch != epoch_) {
+    const uint64_t lost = c->lost;
+    const uint64_t overruns = c->overruns;
+    SeekRing_(capacity, write_seq, c, true);
+    c->lost = lost;
+    c->overruns = overruns;
+  }
+  return ring_poll_n(ring, capacity, write_seq, c, out, max);
+}
+
+void ShmReader::SeekTransactions(RingCursor* c, bool from_oldest) const {
+  if (!c) return;
+  SeekRing_(txn_ring_ ? header_->event_capacity : 0, txn_ring_ ? &header_->event_write_seq : nullptr, c,
+            from_oldest);
+}
+
+size_t ShmReader::PollTransactions(RingCursor* c, TransactionRecord* out, size_t max) {
+  MaybeRemap_();
+  if (!txn_ring_ || !c || !out) return 0;
+  const size_t n = PollRing_(txn_ring_, header_->event_capacity, &header_->event_write_seq, c, out, max);
+  if (n != 0) txn_cursor_seq_ = c->next_seq - 1;
+  return n;
+}
+
+void ShmReader::SeekOrders(RingCursor* c, bool from_oldest) const {
+  if (!c) return;
+  SeekRing_(order_ring_ ? header_->order_capacity : 0, order_ring_ ? &header_->order_write_seq : nullptr, c,
+            from_oldest);
+}
+
+size_t ShmReader::PollOrders(RingCursor* c, OrderRecord* out, size_t max) {
+  MaybeRemap_();
+  if (!order_ring_ || !c || !out) return 0;
+  const size_t n = PollRing_(order_ring_, header_->order_capacity, &header_->order_write_seq, c, out, max);
+  if (n != 0) order_cursor_seq_ = c->next_seq - 1;
+  return n;
+}
+
+size_t ShmReader::ReadHistory(uint32_t symbol_id, HistoryTick* out, size_t max, uint64_t* out_last_seq) {
+  MaybeRemap_();
+  if (out_last_seq) *out_last_seq = 0;
+  if (!history_ || !out || max == 0 || symbol_id >= header_->symbol_count) return 0;
+  const HistoryHead* head = HistoryHead_(symbol_id);
+  const uint64_t depth = header_->history_depth;
+
+  RingCursor c;
+  ::memset(&c, 0, sizeof(c));
+  const uint64_t newest = load_u64_acquire(&head->write_seq);
+  c.next_seq = ring_oldest_seq(newest, depth);
+  if (newest + 1 - c.next_seq > max) c.next_seq = newest + 1 - max;
+  const size_t n = ring_poll_n(history_slots(head), depth, &head->write_seq, &c, out, max);
+  if (n != 0 && out_last_seq) *out_last_seq = c.next_seq - 1;
+  return n;
+}
+
+void ShmReader::SeekHistory(uint32_t symbol_id, RingCursor* c, bool from_oldest) const {
+  if (!c) return;
+  const bool ok = history_ && symbol_id < header_->symbol_count;
+  SeekRing_(ok ? header_->history_depth : 0, ok ? &HistoryHead_(symbol_id)->write_seq : nullptr, c, from_oldest);
+}
+
+size_t ShmReader::PollHistory(uint32_t symbol_id, RingCursor* c, HistoryTick* out, size_t max) {
+  MaybeRemap_();
+  if (!history_ || !c || !out || symbol_id >= header_->symbol_count) return 0;
+  const HistoryHead* head = HistoryHead_(symbol_id);
+  return PollRing_(history_slots(head), header_->history_depth, &head->write_seq, c, out, max);
+}
+
+void ShmReader::SeekSystemEvents(RingCursor* c, bool from_oldest) const {
+  if (!c) return;
+  SeekRing_(sys_events_ ? header_->sys_event_capacity : 0, sys_events_ ? &header_->sys_event_write_seq : nullptr, c,
+            from_oldest);
+}
+
+size_t ShmReader::PollSystemEvents(RingCursor* c, SystemEvent* out, size_t max) {
+  MaybeRemap_();
+  if (!sys_events_ || !c || !out) return 0;
+  return PollRing_(sys_events_, header_->sys_event_capacity, &header_->sys_event_write_seq, c, out, max);
+}
+
+uint32_t ShmReader::FindMarket(const char* market) const {
+  if (!market) return kInvalidSymbolId;
+  char key[sizeof(MarketStatus::market)];
+  ::memset(key, 0, sizeof(key));
+  ::strncpy(key, market, sizeof(key) - 1);
+  const uint32_t n = market_count();
+  for (uint32_t i = 0; i < n; ++i) {
+    // The key is written once, before market_count is released.
+    if (::memcmp(header_->markets[i].v.market, key, sizeof(key)) == 0) return i;
+  }
+  return kInvalidSymbolId;
+}
+
+bool ShmReader::ReadMarketStatus(uint32_t market_id, MarketStatus* out) {
+  MaybeRemap_();
+  if (!sys_events_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || market_id >= market_count()) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+
+  const MarketStatusEntry* e = &header_->markets[market_id];
+  last_read_status_ = ReadSeqlocked_(&e->seq, [&]() {
+    *out = e->v;
+  });
+  return last_read_status_ == kReadOk;
+}
+
+bool ShmReader::ReadOrderQueue(uint32_t symbol_id, uint32_t side, OrderQueueInfo* out, int32_t* volumes,
+                               uint32_t max_items) {
+  MaybeRemap_();
+  if (!order_queues_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || (!volumes && max_items != 0) || symbol_id >= header_->symbol_count || side > kOrderQueueAsk) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+
+  const OrderQueueEntry* q = &order_queues_[static_cast<size_t>(symbol_id) * 2 + side];
+  last_read_status_ = ReadSeqlocked_(&q->seq, [&]() {
+    out->price_x10000 = q->price_x10000;
+    out->time_hhmmssmmm = q->time_hhmmssmmm;
+    out->orders = q->orders;
+    out->last_update_ns = q->last_update_ns;
+    const int32_t items = q->items;
+    // A torn read can see any items value: clamp before sizing the copy, the seq check discards it.
+    out->items = (items < 0) ? 0 : (items > static_cast<int32_t>(kOrderQueueMaxItems))
+                                       ? kOrderQueueMaxItems : static_cast<uint32_t>(items);
+    out->copied = (out->items < max_items) ? out->items : max_items;
+    ::memcpy(volumes, q->volumes, static_cast<size_t>(out->copied) * sizeof(int32_t));
+  });
+  return last_read_status_ == kReadOk;
+}
+
+bool ShmReader::ReadL3Book(uint32_t symbol_id, L3BookHead* out, L3Level* bids, L3Level* asks,
+                           uint32_t max_levels) {
+  MaybeRemap_();
+  if (!l3_books_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || ((!bids || !asks) && max_levels != 0) || symbol_id >= header_->symbol_count) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+
+  const L3BookEntry* e = &l3_books_[symbol_id];
+  uint32_t nb = 0;
+  uint32_t na = 0;
+  last_read_status_ = ReadSeqlocked_(&e->seq, [&]() {
+    *out = e->head;
+    // A torn read can see any level counts: clamp before sizing the copy, the seq check discards it.
+    nb = (out->bid_levels < kL3BookLevels) ? out->bid_levels : kL3BookLevels;
+    na = (out->ask_levels < kL3BookLevels) ? out->ask_levels : kL3BookLevels;
+    if (nb > max_levels) nb = max_levels;
+    if (na > max_levels) na = max_levels;
+    ::memcpy(bids, e->bids, static_cast<size_t>(nb) * sizeof(L3Level));
+    ::memcpy(asks, e->asks, static_cast<size_t>(na) * sizeof(L3Level));
+  });
+  if (last_read_status_ != kReadOk) return false;
+  out->bid_levels = nb;
+  out->ask_levels = na;
+  return true;
+}
+
+uint32_t ShmReader::FindIndex(const char* wind_code) const {
+  if (!index_dir_) return kInvalidSymbolId;
+  char canon[kWindCodeBytes];
+  if (!parse_index_code(wind_code, canon)) return kInvalidSymbolId;
+  return index_dir_find(index_dir_, index_count(), canon);
+}
+
+bool ShmReader::ReadIndex(uint32_t index_id, IndexValues* out, int32_t* out_time) {
+  MaybeRemap_();
+  if (!index_entries_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || index_id >= index_count()) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+
+  const IndexEntry* e = &index_entries_[index_id];
+  int32_t t = 0;
+  last_read_status_ = ReadSeqlocked_(&e->seq, [&]() {
+    *out = e->v;
+    t = e->time_hhmmssmmm;
+  });
+  if (last_read_status_ != kReadOk) return false;
+  if (out_time) *out_time = t;
+  return true;
+}
+
 bool ShmReader::MapAndBind_(int /*fd*/, size_t bytes) {
 #if defined(_WIN32)
   void* p = MapViewOfFile(fd_, FILE_MAP_READ, 0, 0, bytes == 0 ? 0 : bytes);
   if (!p) {
     last_errno_ = static_cast<int>(GetLastError());
-    Close();
+    Unmap_();
     return false;
   }
   base_ = p;
@@ -154,7 +1248,7 @@ bool ShmReader::MapAndBind_(int /*fd*/, size_t bytes) {
   void* p = mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd_, 0);
   if (p == MAP_FAILED) {
     last_errno_ = errno;
-    Close();
+    Unmap_();
     return false;
   }
   base_ = p;
@@ -171,6 +1265,58 @@ bool ShmReader::MapAndBind_(int /*fd*/, size_t bytes) {
 #endif
 
   entries_ = snapshot_table(base_, header_);
+  symbol_index_ = symbol_index(base_, header_);
+  if (symbol_index_ && header_->symbol_index_offset + header_->symbol_index_bytes > static_cast<uint64_t>(bytes_)) {
+    symbol_index_ = nullptr;
+  }
+  txn_ring_ = transaction_ring(base_, header_);
+  if (txn_ring_ && header_->event_ring_offset + header_->event_ring_bytes > static_cast<uint64_t>(bytes_)) {
+    txn_ring_ = nullptr;
+  }
+  order_ring_ = order_ring(base_, header_);
+  if (order_ring_ && header_->order_ring_offset + header_->order_ring_bytes > static_cast<uint64_t>(bytes_)) {
+    order_ring_ = nullptr;
+  }
+  order_queues_ = order_queue_table(base_, header_);
+  if (order_queues_ && header_->order_queue_offset + header_->order_queue_bytes > static_cast<uint64_t>(bytes_)) {
+    order_queues_ = nullptr;
+  }
+  live_trades_ = live_trade_table(base_, header_);
+  if (live_trades_ && header_->live_trade_offset + header_->live_trade_bytes > static_cast<uint64_t>(bytes_)) {
+    live_trades_ = nullptr;
+  }
+  limit_ups_ = limit_up_table(base_, header_);
+  if (limit_ups_ && header_->limit_up_offset + header_->limit_up_bytes > static_cast<uint64_t>(bytes_)) {
+    limit_ups_ = nullptr;
+  }
+  seal_erosions_ = seal_erosion_table(base_, header_);
+  if (seal_erosions_ &&
+      header_->seal_erosion_offset + header_->seal_erosion_bytes > static_cast<uint64_t>(bytes_)) {
+    seal_erosions_ = nullptr;
+  }
+  sys_events_ = sys_event_ring(base_, header_);
+  if (sys_events_ && header_->sys_event_offset + header_->sys_event_bytes > static_cast<uint64_t>(bytes_)) {
+    sys_events_ = nullptr;
+  }
+  history_ = history_head(base_, header_, 0);
+  if (history_ && header_->history_offset + header_->history_bytes > static_cast<uint64_t>(bytes_)) {
+    history_ = nullptr;
+  }
+  l3_books_ = l3_book_table(base_, header_);
+  if (l3_books_ && header_->l3_book_offset + header_->l3_book_bytes > static_cast<uint64_t>(bytes_)) {
+    l3_books_ = nullptr;
+  }
+  feed_stats_ = feed_stats(base_, header_);
+  if (feed_stats_ && header_->feed_stats_offset + header_->feed_stats_bytes > static_cast<uint64_t>(bytes_)) {
+    feed_stats_ = nullptr;
+  }
+  index_dir_ = index_dir(base_, header_);
+  index_entries_ = index_entries(base_, header_);
+  if (!index_dir_ || !index_entries_ ||
+      header_->index_entries_offset + header_->index_entries_bytes > static_cast<uint64_t>(bytes_)) {
+    index_dir_ = nullptr;
+    index_entries_ = nullptr;
+  }
   return true;
 }
 
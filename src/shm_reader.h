@@ -7,16 +7,118 @@
 //   r.Open("/md_gate_shm");
 //   mdg::MarketData320 md;
 //   r.ReadSnapshot(symbol_id, &md);
+//   r.Heartbeat(now_ns);   // once per strategy cycle: liveness + lag + counters into the reader registry
+//
+// Gateway restarts: r.StartWatcher(100) probes writer_pid / writer_start_ns / inode in the background;
+// the remap itself happens on the next read call on the caller's thread, and epoch() is bumped so
+// callers can drop cached symbol ids. ShmReader is not thread-safe: one reading thread per instance.
 
+#include "marketdata_payload.h"
 #include "struct_def.h"
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace mdg {
 
+// -------------------------
+// Field projection (compile-time offsets into MarketDataPayloadV1)
+// -------------------------
+//
+// C++14 has no `template <auto>`, so fields are named via MDG_PAYLOAD_FIELD(member) which yields a
+// PayloadField<offset, type>. Arrays are projected per element, e.g. MDG_PAYLOAD_FIELD(bid_price_x10000[0]).
+//
+//   typedef MDG_PAYLOAD_FIELD(last_x10000) Last;
+//   typedef MDG_PAYLOAD_FIELD(bid_price_x10000[0]) Bid1;
+//   std::tuple<int64_t, int64_t> v;
+//   r.ReadFields<Last, Bid1>(symbol_id, &v);   // std::get<0>(v) = last, std::get<1>(v) = bid1
+
+template <size_t Offset, typename T>
+struct PayloadField {
+  typedef T type;
+  static const size_t offset = Offset;
+  static_assert(!std::is_array<T>::value, "project array members per element, e.g. bid_vol[0]");
+  static_assert(Offset + sizeof(T) <= kMarketDataBytes, "field outside the 320B payload");
+};
+
+#define MDG_PAYLOAD_FIELD(member)                                              \
+  ::mdg::PayloadField<offsetof(::mdg::MarketDataPayloadV1, member),             \
+                      std::remove_reference<decltype(::mdg::MarketDataPayloadV1::member)>::type>
+
+template <typename... F, typename Tuple, size_t... I>
+inline void copy_payload_fields(const uint8_t* payload, Tuple* out, std::index_sequence<I...>) {
+  const int expand[] = {0, (::memcpy(&std::get<I>(*out), payload + F::offset, sizeof(typename F::type)), 0)...};
+  (void)expand;
+}
+
+// Result of reads that can do more than succeed/fail.
+enum ReadStatus {
+  kReadOk = 0,             // out filled
+  kReadUnchanged = 1,      // ReadIfChanged: seq matches the caller's, out untouched
+  kReadRetryExceeded = 2,  // entry kept changing under the reader (heavy write load) for the whole wait budget
+  kReadInvalidArg = 3,     // symbol_id out of range or null pointer
+  kReadNotMapped = 4,      // not open (or a remap failed)
+  kReadWriterStuck = 5,    // seq stayed odd at one value for the whole wait: writer stalled/died mid-write
+  kReadNotReady = 6,       // mirror set registered but not filled by the gateway yet (mirror_ready() false)
+};
+
+// How a reader waits on a torn entry: spin_count pause-spins, then yield_count sched_yield()s, then
+// sleep_count sleeps of sleep_us each; the read fails once all steps are spent. Per reader instance.
+// A futex wait is deliberately not offered: it would cost the writer a FUTEX_WAKE syscall per update.
+struct ReadWaitPolicy {
+  uint32_t spin_count;
+  uint32_t yield_count;
+  uint32_t sleep_count;
+  uint32_t sleep_us;
+};
+
+// Dedicated core, never leaves the CPU (the historical fixed 200-spin budget).
+static const ReadWaitPolicy kWaitPolicyLatencyCritical = {200, 0, 0, 0};
+// Default: spin first, then give the core away a few times before failing (~tens of us worst case).
+static const ReadWaitPolicy kWaitPolicyDefault = {200, 16, 0, 0};
+// Shared cores (monitors, recorders): short spin, then yield, then sleep; ~5ms plus timer slack.
+static const ReadWaitPolicy kWaitPolicyBackground = {16, 8, 50, 100};
+
+// Per-reader read instrumentation (ShmReader::GetStats). Mirrored into the registry slot on Heartbeat().
+// torn rate = torn_reads / (reads_ok + read_failures).
+struct ReaderStats {
+  uint64_t reads_ok;
+  uint64_t read_retries;    // seqlock retries summed over all reads
+  uint64_t read_failures;   // = retry_exceeded + writer_stuck
+  uint64_t torn_reads;      // successful reads that needed at least one retry
+  uint64_t retry_exceeded;  // wait budget spent while the writer kept updating the entry
+  uint64_t writer_stuck;    // wait budget spent on one odd seq
+  uint64_t stale_samples;
+  uint64_t stale_max_ns;
+  uint64_t retry_hist[kReaderRetryBuckets];  // successful reads by retries, see reader_retry_bucket
+  uint64_t stale_hist[kReaderStaleBuckets];  // sampled now - entry.last_update_ns, see reader_stale_bucket
+};
+
+// Fixed part of one order queue side (ShmReader::ReadOrderQueue).
+struct OrderQueueInfo {
+  int64_t  price_x10000;
+  int32_t  time_hhmmssmmm;
+  int32_t  orders;          // orders at the price (may exceed items)
+  uint32_t items;           // volumes held by the gateway (<= kOrderQueueMaxItems)
+  uint32_t copied;          // volumes copied into the caller's buffer (<= max_items)
+  uint64_t last_update_ns;  // 0 = never updated
+};
+
 class ShmReader {
 public:
+  static const uint32_t kDefaultMaxSpins = 200;  // ReadSnapshotSpin budget; other reads use the wait policy
+  static const size_t kBatchPrefetchAhead = 4;  // entries (4 x 384B in flight)
+  static const uint32_t kDefaultCutAttempts = 64;
+  static const uint32_t kDefaultStaleSampleEvery = 64;  // successful reads per staleness sample
+
   ShmReader();
   ~ShmReader();
 
@@ -24,9 +126,26 @@ public:
   ShmReader& operator=(const ShmReader&) = delete;
 
   // Open SHM read-only (shm_open + mmap PROT_READ).
+  // If the segment has a reader registry, also maps that region writable and claims a slot
+  // (best-effort: Open still succeeds without a slot).
   bool Open(const char* shm_name);
   void Close();
 
+  // --- Gateway restart handling ---
+  // epoch(): incremented on every successful (re)map; cached symbol ids are valid for one epoch.
+  uint32_t epoch() const { return epoch_; }
+  // Synchronous check: remaps if the writer changed (new inode, writer_pid or writer_start_ns).
+  // Returns true if a valid mapping is in place afterwards.
+  bool CheckWriter();
+  // Unconditional unmap + remap of the same name (keeps the watcher running). On failure the reader stays
+  // unmapped; the watcher (or the next CheckWriter) retries.
+  bool Reconnect();
+  // Background watcher: probes the segment every interval_ms without touching the live mapping and
+  // flags a remap; the remap runs inline on the next read call. Stopped by Close().
+  bool StartWatcher(uint32_t interval_ms);
+  void StopWatcher();
+  bool remap_pending() const { return remap_pending_.load(std::memory_order_relaxed); }
+
   int last_errno() const { return last_errno_; }
 
   const void* base() const { return base_; }
@@ -42,31 +161,336 @@ public:
   inline uint32_t last_err() const { return header_ ? load_u32_acquire(&header_->last_err) : 0; }
   inline uint64_t writer_start_ns() const { return header_ ? header_->writer_start_ns : 0; }
 
-  // Read latest snapshot with seqlock retry.
-  // - returns true on success; false if retries exceeded.
+  // wind_code ("600000.SH") -> symbol_id via the SHM symbol index; kInvalidSymbolId if unknown.
+  // No allocation. Falls back to a linear symbol_dir scan when the segment has no index.
+  uint32_t FindSymbol(const char* wind_code) const;
+
+  // Wait policy used by ReadSnapshot / ReadSnapshots / ReadIfChanged / ReadFields (kWaitPolicyDefault).
+  void SetWaitPolicy(const ReadWaitPolicy& policy) { wait_policy_ = policy; }
+  const ReadWaitPolicy& wait_policy() const { return wait_policy_; }
+
+  // Why the last bool-returning read (ReadSnapshot, ReadSnapshotSpin, ReadFields) failed; for
+  // ReadSnapshots the last per-entry failure. kReadOk after a successful read.
+  ReadStatus last_read_status() const { return last_read_status_; }
+
+  // Read latest snapshot with seqlock retry under the wait policy.
+  // - returns true on success; false if the wait budget ran out (see last_read_status()).
   // - out_seq_even: optional, the even seq observed.
   bool ReadSnapshot(uint32_t symbol_id, MarketData320* out, uint32_t* out_seq_even);
 
-  // Convenience: best-effort read with bounded spins.
+  // ReadSnapshot plus the live trade overlay (gateway subscribed to TRANSACTION): when the overlay is
+  // ahead of the snapshot, last / volume / turnover / time come from it (high / low are widened to
+  // the live last). Two seqlocked reads, not one cut: the overlay is only applied if its volume is not
+  // behind the snapshot's. out_live (optional): true if the overlay was applied.
+  bool ReadSnapshotLive(uint32_t symbol_id, MarketData320* out, uint32_t* out_seq_even, bool* out_live = nullptr);
+  bool has_live_trades() const { return live_trades_ != nullptr; }
+  // Seqlock read of the overlay alone under the wait policy.
+  bool ReadLiveTrade(uint32_t symbol_id, LiveTrade* out);
+
+  // Convenience: best-effort read with max_spins back-to-back attempts (ignores the wait policy).
   bool ReadSnapshotSpin(uint32_t symbol_id, MarketData320* out, uint32_t max_spins, uint32_t* out_seq_even);
 
+  // Batch read of a basket (out[i] <- ids[i]).
+  // - pass 1: one seqlock attempt per entry, prefetching entries kBatchPrefetchAhead ahead
+  // - pass 2: retries only the entries that were torn in pass 1 (under the wait policy)
+  // seqs (required) receives the even seq per entry, or kSeqInvalid if the entry could not be read
+  // (bad id or still torn). Returns the number of entries read successfully.
+  size_t ReadSnapshots(const uint32_t* ids, size_t n, MarketData320* out, uint32_t* seqs);
+
+  // Change-aware read for polling loops. One acquire load of entry.seq; if it equals *last_seq the
+  // payload cachelines are not touched and kReadUnchanged is returned. Otherwise reads the snapshot
+  // and stores the new even seq into *last_seq. Initialize *last_seq to kSeqInvalid.
+  ReadStatus ReadIfChanged(uint32_t symbol_id, uint32_t* last_seq, MarketData320* out);
+
+  // Cross-symbol consistent read: every entry copied belongs to the same publish generation (no
+  // writer batch began or ended during the copy), so e.g. a pair never mixes pre- and post-09:25 data.
+  // - ids == nullptr: bulk copy of the whole table (out must hold symbol_count() entries, n ignored)
+  // - ids != nullptr: copy out[i] <- ids[i] for i < n
+  // Retries the whole cut up to max_attempts times. While a batch is in flight it waits under the wait
+  // policy instead (one budget per batch, kReadWriterStuck if the batch never ends), costing no attempt.
+  // On kReadOk, *out_generation (optional) is the generation (header.publish_end) the cut is consistent
+  // with.
+  ReadStatus ReadCut(const uint32_t* ids, size_t n, MarketData320* out, uint64_t* out_generation,
+                     uint32_t max_attempts = kDefaultCutAttempts);
+
+  // Seqlock read of selected payload fields only: copies sizeof(field) bytes per field, so only the
+  // cachelines holding those fields are touched (instead of the full 320B payload).
+  template <typename... F>
+  bool ReadFields(uint32_t symbol_id, std::tuple<typename F::type...>* out, uint32_t* out_seq_even = nullptr);
+
+  // --- Filtered mirror: dense per-reader copy of an interest set ---
+  // Publishes ids (n <= kMirrorMaxSymbols, caller's order) in a free mirror; the gateway fills it and
+  // starts fan-out on its next mirror scan (heartbeat period), after which mirror_ready() is true and
+  // mirror position i tracks entries[ids[i]]. Calling again replaces the set. Kept across gateway
+  // restarts (re-registered on remap). False if the segment has no mirrors or none is free.
+  bool RegisterMirror(const uint32_t* ids, uint32_t n);
+  void ReleaseMirror();
+  bool mirror_ready() const {
+    return mirror_ctl_ && load_u32_acquire(&mirror_ctl_->active_seq) == mirror_request_seq_;
+  }
+  uint32_t mirror_count() const { return mirror_ctl_ ? static_cast<uint32_t>(mirror_ids_.size()) : 0; }
+  // mirror_count() contiguous entries in registration order; nullptr without a mirror.
+  const SnapshotEntry* mirror_entries() const { return mirror_entries_; }
+  // Seqlock read of mirror position pos under the wait policy. kReadNotReady until mirror_ready(): a
+  // replaced set may still hold the previous set's entries.
+  bool ReadMirror(uint32_t pos, MarketData320* out, uint32_t* out_seq_even);
+  // Stream the whole mirror: out[i] <- position i, seqs as in ReadSnapshots. Returns entries read.
+  size_t ReadMirrorAll(MarketData320* out, uint32_t* seqs);
+
+  // --- Transaction ring: tick-by-tick trades (gateway subscribed with DATA_TYPE_TRANSACTION) ---
+  bool has_transaction_ring() const { return txn_ring_ != nullptr; }
+  // Position c at the next record to be published (from_oldest=false) or at the oldest record the
+  // ring still holds. Resets c->lost / c->overruns.
+  void SeekTransactions(RingCursor* c, bool from_oldest) const;
+  // Copy up to max records from c onward into out (ring order); returns the count, 0 if nothing new.
+  // If the writer lapped c, c jumps to the oldest record still held and c->lost grows by the records
+  // skipped. A cursor from an earlier epoch() (or zero-initialized) restarts at the oldest record held.
+  size_t PollTransactions(RingCursor* c, TransactionRecord* out, size_t max);
+
+  // --- Order ring: tick-by-tick orders (DATA_TYPE_ORDER); same cursor semantics as transactions ---
+  bool has_order_ring() const { return order_ring_ != nullptr; }
+  void SeekOrders(RingCursor* c, bool from_oldest) const;
+  size_t PollOrders(RingCursor* c, OrderRecord* out, size_t max);
+
+  // --- Order queue table: best-price per-order volumes (DATA_TYPE_ORDERQUEUE) ---
+  bool has_order_queues() const { return order_queues_ != nullptr; }
+  // Seqlock read of one side (kOrderQueueBid / kOrderQueueAsk) under the wait policy. Copies only
+  // the first min(items, max_items) volumes (volumes may be nullptr with max_items = 0 for the
+  // fixed part alone). False on failure, see last_read_status().
+  bool ReadOrderQueue(uint32_t symbol_id, uint32_t side, OrderQueueInfo* out, int32_t* volumes, uint32_t max_items);
+
+  // --- L3 book table: SZ books rebuilt from orders + trades (gateway started with --l3-book) ---
+  bool has_l3_books() const { return l3_books_ != nullptr; }
+  // Seqlock read of one symbol's book under the wait policy. Copies the head and up to max_levels
+  // levels per side (bids / asks may be nullptr with max_levels = 0); out->bid_levels / ask_levels are
+  // the copied counts. False on failure, see last_read_status().
+  bool ReadL3Book(uint32_t symbol_id, L3BookHead* out, L3Level* bids, L3Level* asks, uint32_t max_levels);
+
+  // --- Limit-up state: per-symbol limit-up lifecycle kept by the gateway from snapshots ---
+  bool has_limit_up() const { return limit_ups_ != nullptr; }
+  // Seqlock read under the wait policy. False on failure, see last_read_status().
+  bool ReadLimitUp(uint32_t symbol_id, LimitUpState* out);
+  // Seal erosion of limit-up symbols (w[i] covers kSealWindowMs[i]); same read semantics.
+  bool has_seal_erosion() const { return seal_erosions_ != nullptr; }
+  bool ReadSealErosion(uint32_t symbol_id, SealErosion* out);
+
+  // --- Snapshot history: recent snapshots per symbol (gateway started with --history-depth) ---
+  bool has_history() const { return history_ != nullptr; }
+  // Slots per symbol; up to history_depth() - 1 ticks can be read back.
+  uint32_t history_depth() const { return history_ ? header_->history_depth : 0; }
+  // Lock-free range read of the newest ticks of symbol_id: copies up to max into out, oldest first,
+  // and returns the count. out_last_seq (optional) receives the per-symbol sequence number of the
+  // newest tick copied (0 if none), so a caller can tell how many are new since its previous call.
+  size_t ReadHistory(uint32_t symbol_id, HistoryTick* out, size_t max, uint64_t* out_last_seq = nullptr);
+  // Incremental read, one cursor per symbol; same semantics as SeekTransactions / PollTransactions.
+  void SeekHistory(uint32_t symbol_id, RingCursor* c, bool from_oldest) const;
+  size_t PollHistory(uint32_t symbol_id, RingCursor* c, HistoryTick* out, size_t max);
+
+  // --- Index table: index levels (gateway started with --indices) ---
+  bool has_index_table() const { return index_entries_ != nullptr; }
+  uint32_t index_count() const { return index_entries_ ? load_u32_acquire(&header_->index_count) : 0; }
+  // "000300.SH" -> index id via the index directory; kInvalidSymbolId if unknown. Ids are stable per epoch().
+  uint32_t FindIndex(const char* wind_code) const;
+  // Seqlock read of one index under the wait policy. out_time (optional): nTime HHMMSSmmm, 0 = never
+  // updated. False on failure, see last_read_status().
+  bool ReadIndex(uint32_t index_id, IndexValues* out, int32_t* out_time);
+
+  // --- System events: market open / clear / close, date changes, added codes (TDF system messages) ---
+  bool has_system_events() const { return sys_events_ != nullptr; }
+  // Same cursor semantics as SeekTransactions / PollTransactions.
+  void SeekSystemEvents(RingCursor* c, bool from_oldest) const;
+  size_t PollSystemEvents(RingCursor* c, SystemEvent* out, size_t max);
+  uint32_t market_count() const {
+    if (!sys_events_) return 0;
+    const uint32_t n = load_u32_acquire(&header_->market_count);
+    return (n < kMaxMarkets) ? n : kMaxMarkets;
+  }
+  // "SH" / "SZ" -> market id (header.markets index); kInvalidSymbolId if not seen yet.
+  uint32_t FindMarket(const char* market) const;
+  // Seqlock read of one market's status under the wait policy. False on failure, see last_read_status().
+  bool ReadMarketStatus(uint32_t market_id, MarketStatus* out);
+
+  // --- Feed integrity ---
+  // kEntryFlag* of one symbol (0 if out of range). Sticky for the gateway's lifetime: a set
+  // kEntryFlagTickGap means state derived from the tick streams (books, flows) missed records.
+  uint32_t entry_flags(uint32_t symbol_id) const {
+    return (entries_ && header_ && symbol_id < header_->symbol_count) ? load_u32_acquire(&entries_[symbol_id].flags)
+                                                                      : 0;
+  }
+  // Per-stream gap stats; feed_stream_count() slots are in use. nullptr on segments without them.
+  const FeedStreamStats* feed_streams() const { return feed_stats_; }
+  uint32_t feed_stream_count() const { return feed_stats_ ? load_u32_acquire(&header_->feed_stats_count) : 0; }
+
   // Validate header ABI (magic/version/size).
   bool ValidateHeader() const;
 
+  // Counters and histograms since Open(). Retry counts are per read: seqlock attempts for snapshot
+  // reads, whole-cut attempts for ReadCut. Staleness is sampled (one clock read) every
+  // SetStaleSampleEvery() successful single-entry reads; ReadCut is not sampled.
+  const ReaderStats& GetStats() const { return stats_; }
+  // n is rounded up to a power of two; 0 disables staleness sampling.
+  void SetStaleSampleEvery(uint32_t n);
+
+  // Reader registry slot claimed on Open(); nullptr if none.
+  const ReaderSlot* reader_slot() const { return slot_; }
+
+  // Refresh this reader's registry slot: heartbeat_ns, cursor (header.last_md_ns) and GetStats().
+  // A few dozen relaxed stores to the reader's own slot; call from the strategy loop (e.g. once per cycle).
+  void Heartbeat(uint64_t now_ns);
+
 private:
+  // Read entry points call this: one relaxed load unless the watcher flagged a writer change.
+  inline void MaybeRemap_() {
+    if (remap_pending_.load(std::memory_order_acquire)) Reconnect();
+  }
+  // close_on_map_failure: Open() leaves the reader closed if the first mapping fails; Reconnect() keeps
+  // the name and mirror set for the next attempt.
+  bool OpenMapping_(bool close_on_map_failure);
+  void Unmap_();
+  bool WriterChanged_() const;
   bool MapAndBind_(int fd, size_t bytes);
+  // One wait step of `policy`; false once step is past its budget. Spins inline, yields/sleeps out of line.
+  inline bool WaitStep_(const ReadWaitPolicy& policy, uint32_t step) const {
+    if (step < policy.spin_count) {
+      cpu_relax();
+      return true;
+    }
+    return WaitSlow_(policy, step - policy.spin_count);
+  }
+  bool WaitSlow_(const ReadWaitPolicy& policy, uint32_t step) const;
+  ReadStatus ReadEntry_(const SnapshotEntry* e, MarketData320* out, uint32_t* out_seq_even,
+                        const ReadWaitPolicy& policy);
+  // Seqlock read loop of the side tables (limit-up, live trade, order queue, ...) under wait_policy_.
+  // copy() copies the record; it may run on a torn record, so it must clamp anything it sizes a copy by.
+  template <typename Copy>
+  ReadStatus ReadSeqlocked_(const AtomicU32* seq, Copy copy);
+  bool CopyCut_(const uint32_t* ids, size_t n, MarketData320* out);
+  // Epoch-aware wrappers over ring_seek / ring_poll_n shared by the event rings and the history rings.
+  void SeekRing_(uint32_t capacity, const AtomicU64* write_seq, RingCursor* c, bool from_oldest) const;
+  template <typename Slot, typename Record>
+  size_t PollRing_(const Slot* ring, uint32_t capacity, const AtomicU64* write_seq, RingCursor* c, Record* out,
+                   size_t max);
+  inline const HistoryHead* HistoryHead_(uint32_t symbol_id) const {
+    return reinterpret_cast<const HistoryHead*>(reinterpret_cast<const uint8_t*>(history_) +
+                                                static_cast<size_t>(symbol_id) * header_->history_stride_bytes);
+  }
+  // Instrumentation. e may be nullptr (no staleness sample).
+  inline void NoteRead_(const SnapshotEntry* e, uint32_t retries) {
+    ++stats_.reads_ok;
+    ++stats_.retry_hist[retries == 0 ? 0 : reader_retry_bucket(retries)];
+    if (retries != 0) {
+      stats_.read_retries += retries;
+      ++stats_.torn_reads;
+    }
+    if (e && (stats_.reads_ok & stale_sample_mask_) == 0) NoteStaleness_(e);
+  }
+  inline void NoteFailure_(ReadStatus st, uint32_t retries) {
+    ++stats_.read_failures;
+    stats_.read_retries += retries;
+    if (st == kReadWriterStuck) {
+      ++stats_.writer_stuck;
+    } else {
+      ++stats_.retry_exceeded;
+    }
+  }
+  void NoteStaleness_(const SnapshotEntry* e);
+  void ClaimReaderSlot_();
+  void ReleaseReaderSlot_();
+  void* MapWritable_(uint64_t offset, uint64_t bytes);
+  void UnmapWritable_(void* p, size_t bytes);
+  bool ClaimMirror_();
+  void ReleaseMirror_();
 
 private:
   const void* base_;
   size_t bytes_;
   const ShmHeader* header_;
   const SnapshotEntry* entries_;
+  const SymbolIndexSlot* symbol_index_;
+  const TransactionSlot* txn_ring_;
+  uint64_t txn_cursor_seq_;   // last transaction seq consumed, flushed into slot_ by Heartbeat()
+  const OrderQueueEntry* order_queues_;
+  const char* index_dir_;
+  const IndexEntry* index_entries_;
+  const FeedStreamStats* feed_stats_;
+  const L3BookEntry* l3_books_;
+  const LiveTradeEntry* live_trades_;
+  const SystemEventSlot* sys_events_;
+  const LimitUpEntry* limit_ups_;
+  const SealErosionEntry* seal_erosions_;
+  const HistoryHead* history_;  // symbol 0's ring; symbol i's at i * header.history_stride_bytes
+  const OrderSlot* order_ring_;
+  uint64_t order_cursor_seq_; // last order seq consumed, flushed into slot_ by Heartbeat()
+  void* registry_map_;        // writable view of the reader registry region
+  size_t registry_map_bytes_;
+  ReaderSlot* slot_;
+  void* mirror_map_;          // writable view of the mirror control region
+  size_t mirror_map_bytes_;
+  MirrorControl* mirror_ctl_;
+  const SnapshotEntry* mirror_entries_;
+  uint32_t mirror_request_seq_;
+  std::vector<uint32_t> mirror_ids_;  // interest set, re-published after a remap
+
+  // Local read counters/cursors, flushed into slot_ by Heartbeat().
+  uint64_t cursor_generation_;
+  ReaderStats stats_;
+  uint64_t stale_sample_mask_;  // sample when (reads_ok & mask) == 0; ~0 = off
+  ReadWaitPolicy wait_policy_;
+  ReadStatus last_read_status_;
 #if defined(_WIN32)
   void* fd_; // HANDLE
 #else
   int fd_;
 #endif
   int last_errno_;
+
+  // Reconnect state. mapped_* are read by the watcher thread.
+  char shm_name_[256];
+  uint32_t epoch_;
+  std::atomic<uint32_t> mapped_pid_;
+  std::atomic<uint64_t> mapped_start_ns_;
+  std::atomic<uint64_t> mapped_ino_;
+  std::atomic<bool> remap_pending_;
+  std::atomic<bool> watch_stop_;
+  std::thread watcher_;
 };
 
+template <typename... F>
+bool ShmReader::ReadFields(uint32_t symbol_id, std::tuple<typename F::type...>* out, uint32_t* out_seq_even) {
+  MaybeRemap_();
+  if (!entries_ || !header_) {
+    last_read_status_ = kReadNotMapped;
+    return false;
+  }
+  if (!out || symbol_id >= header_->symbol_count) {
+    last_read_status_ = kReadInvalidArg;
+    return false;
+  }
+
+  const SnapshotEntry* e = &entries_[symbol_id];
+  const uint32_t first = load_u32_acquire(&e->seq);
+  bool moved = false;
+  for (uint32_t step = 0;; ++step) {
+    const uint32_t s1 = load_u32_acquire(&e->seq);
+    if ((s1 & 1U) == 0) {
+      compiler_barrier();
+      copy_payload_fields<F...>(e->payload.bytes, out, std::index_sequence_for<F...>());
+      compiler_barrier();
+      const uint32_t s2 = load_u32_acquire(&e->seq);
+      if (s1 == s2) {
+        if (out_seq_even) *out_seq_even = s2;
+        NoteRead_(e, step);
+        last_read_status_ = kReadOk;
+        return true;
+      }
+    }
+    if (s1 != first || (s1 & 1U) == 0) moved = true;  // even s1 here means s2 differed
+    if (!WaitStep_(wait_policy_, step)) {
+      last_read_status_ = moved ? kReadRetryExceeded : kReadWriterStuck;
+      NoteFailure_(last_read_status_, step);
+      return false;
+    }
+  }
+}
+
 } // namespace mdg
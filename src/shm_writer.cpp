@@ -9,6 +9,7 @@
 #else
 #include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <time.h>
@@ -50,6 +51,21 @@ static uint32_t GetUid() {
 #endif
 }
 
+// Liveness probe for reader registry reclaim. Conservative: only "definitely gone" returns false.
+static bool IsProcessAlive(uint32_t pid) {
+  if (pid == 0) return false;
+#if defined(_WIN32)
+  HANDLE h = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+  if (!h) return GetLastError() != ERROR_INVALID_PARAMETER;
+  const DWORD r = WaitForSingleObject(h, 0);
+  CloseHandle(h);
+  return r != WAIT_OBJECT_0;
+#else
+  if (kill(static_cast<pid_t>(pid), 0) == 0) return true;
+  return errno != ESRCH;
+#endif
+}
+
 static void SetLastErrno(int* out, int err) {
   if (out) *out = err;
 }
@@ -61,18 +77,41 @@ ShmWriter::ShmWriter()
       bytes_(0),
       header_(nullptr),
       symbol_dir_(nullptr),
+      symbol_index_(nullptr),
       entries_(nullptr),
+      readers_(nullptr),
+      mirror_ctl_(nullptr),
+      mirror_entries_(nullptr),
+      txn_ring_(nullptr),
+      txn_mask_(0),
+      order_ring_(nullptr),
+      order_mask_(0),
+      order_queues_(nullptr),
+      index_dir_(nullptr),
+      index_entries_(nullptr),
+      feed_stats_(nullptr),
+      l3_books_(nullptr),
+      live_trades_(nullptr),
+      history_(nullptr),
+      history_stride_(0),
+      history_mask_(0),
+      sys_events_(nullptr),
+      limit_ups_(nullptr),
+      seal_erosions_(nullptr),
       create_symbol_count_(0),
+      layout_(),
 #if defined(_WIN32)
       fd_(nullptr),
 #else
       fd_(-1),
 #endif
-      last_errno_(0) {}
+      last_errno_(0) {
+  ResetMirrors_();
+}
 
 ShmWriter::~ShmWriter() { Close(); }
 
-bool ShmWriter::Create(const char* shm_name, uint32_t symbol_count) {
+bool ShmWriter::Create(const char* shm_name, uint32_t symbol_count, const ShmCreateOptions& opts) {
   Close();
   last_errno_ = 0;
 
@@ -84,13 +123,18 @@ bool ShmWriter::Create(const char* shm_name, uint32_t symbol_count) {
     last_errno_ = EINVAL;
     return false;
   }
+  if (opts.transaction_ring_capacity > kMaxRingCapacity || opts.order_ring_capacity > kMaxRingCapacity) {
+    last_errno_ = EINVAL;
+    return false;
+  }
+  if (opts.history_depth > kMaxHistoryDepth) {
+    last_errno_ = EINVAL;
+    return false;
+  }
 
   create_symbol_count_ = symbol_count;
-  const size_t header_bytes = align_up(sizeof(ShmHeader), kCacheLineBytes);
-  const size_t symbol_dir_bytes = align_up(static_cast<size_t>(symbol_count) * static_cast<size_t>(kSymbolDirEntryBytes),
-                                           kCacheLineBytes);
-  const size_t snapshot_bytes = static_cast<size_t>(symbol_count) * sizeof(SnapshotEntry);
-  const size_t total_bytes = header_bytes + symbol_dir_bytes + snapshot_bytes;
+  ComputeLayout_(symbol_count, opts, &layout_);
+  const size_t total_bytes = static_cast<size_t>(layout_.total_bytes);
 
 #if defined(_WIN32)
   HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
@@ -167,7 +211,28 @@ void ShmWriter::Close() {
   bytes_ = 0;
   header_ = nullptr;
   symbol_dir_ = nullptr;
+  symbol_index_ = nullptr;
   entries_ = nullptr;
+  readers_ = nullptr;
+  mirror_ctl_ = nullptr;
+  mirror_entries_ = nullptr;
+  txn_ring_ = nullptr;
+  txn_mask_ = 0;
+  order_ring_ = nullptr;
+  order_mask_ = 0;
+  order_queues_ = nullptr;
+  index_dir_ = nullptr;
+  index_entries_ = nullptr;
+  feed_stats_ = nullptr;
+  l3_books_ = nullptr;
+  live_trades_ = nullptr;
+  history_ = nullptr;
+  history_stride_ = 0;
+  history_mask_ = 0;
+  sys_events_ = nullptr;
+  limit_ups_ = nullptr;
+  seal_erosions_ = nullptr;
+  ResetMirrors_();
 
 #if defined(_WIN32)
   if (fd_) {
@@ -239,6 +304,11 @@ bool ShmWriter::MapAndBind_(int /*fd*/, size_t bytes, bool init_header) {
     }
     entries_ = snapshot_table(base_, header_);
     InitSnapshotTable_(header_->symbol_count);
+    if (header_->symbol_index_offset != 0) {
+      // All slots empty (kSymbolKeyEmpty = 0xFFFFFFFF).
+      ::memset(reinterpret_cast<uint8_t*>(base_) + header_->symbol_index_offset, 0xFF,
+               static_cast<size_t>(header_->symbol_index_bytes));
+    }
   } else {
     // Basic sanity bind: snapshot_offset is trusted only after ValidateHeader by caller.
   }
@@ -249,16 +319,206 @@ bool ShmWriter::MapAndBind_(int /*fd*/, size_t bytes, bool init_header) {
   if (!entries_) {
     entries_ = snapshot_table(base_, header_);
   }
+  if (header_->symbol_index_offset != 0) {
+    symbol_index_ = reinterpret_cast<SymbolIndexSlot*>(reinterpret_cast<uint8_t*>(base_) +
+                                                       static_cast<size_t>(header_->symbol_index_offset));
+  }
+  readers_ = reader_registry(base_, header_);
+  if (header_->mirror_ctl_offset != 0 && header_->mirror_entries_offset != 0) {
+    uint8_t* b = reinterpret_cast<uint8_t*>(base_);
+    mirror_ctl_ = reinterpret_cast<MirrorControl*>(b + static_cast<size_t>(header_->mirror_ctl_offset));
+    mirror_entries_ = reinterpret_cast<SnapshotEntry*>(b + static_cast<size_t>(header_->mirror_entries_offset));
+  }
+  if (::mdg::transaction_ring(base_, header_) && header_->event_capacity != 0) {
+    txn_ring_ = reinterpret_cast<TransactionSlot*>(reinterpret_cast<uint8_t*>(base_) +
+                                                   static_cast<size_t>(header_->event_ring_offset));
+    txn_mask_ = header_->event_capacity - 1;
+  }
+  if (::mdg::order_ring(base_, header_) && header_->order_capacity != 0) {
+    order_ring_ = reinterpret_cast<OrderSlot*>(reinterpret_cast<uint8_t*>(base_) +
+                                               static_cast<size_t>(header_->order_ring_offset));
+    order_mask_ = header_->order_capacity - 1;
+  }
+  if (::mdg::order_queue_table(base_, header_)) {
+    order_queues_ = reinterpret_cast<OrderQueueEntry*>(reinterpret_cast<uint8_t*>(base_) +
+                                                       static_cast<size_t>(header_->order_queue_offset));
+  }
+  if (::mdg::l3_book_table(base_, header_)) {
+    l3_books_ = reinterpret_cast<L3BookEntry*>(reinterpret_cast<uint8_t*>(base_) +
+                                               static_cast<size_t>(header_->l3_book_offset));
+  }
+  if (::mdg::live_trade_table(base_, header_)) {
+    live_trades_ = reinterpret_cast<LiveTradeEntry*>(reinterpret_cast<uint8_t*>(base_) +
+                                                     static_cast<size_t>(header_->live_trade_offset));
+  }
+  if (::mdg::history_head(base_, header_, 0) && header_->history_depth != 0) {
+    history_ = reinterpret_cast<uint8_t*>(base_) + static_cast<size_t>(header_->history_offset);
+    history_stride_ = header_->history_stride_bytes;
+    history_mask_ = header_->history_depth - 1;
+  }
+  if (::mdg::limit_up_table(base_, header_)) {
+    limit_ups_ = reinterpret_cast<LimitUpEntry*>(reinterpret_cast<uint8_t*>(base_) +
+                                                 static_cast<size_t>(header_->limit_up_offset));
+  }
+  if (::mdg::seal_erosion_table(base_, header_)) {
+    seal_erosions_ = reinterpret_cast<SealErosionEntry*>(reinterpret_cast<uint8_t*>(base_) +
+                                                         static_cast<size_t>(header_->seal_erosion_offset));
+  }
+  if (::mdg::sys_event_ring(base_, header_) && header_->sys_event_capacity != 0) {
+    sys_events_ = reinterpret_cast<SystemEventSlot*>(reinterpret_cast<uint8_t*>(base_) +
+                                                     static_cast<size_t>(header_->sys_event_offset));
+  }
+  if (::mdg::feed_stats(base_, header_)) {
+    feed_stats_ = reinterpret_cast<FeedStreamStats*>(reinterpret_cast<uint8_t*>(base_) +
+                                                     static_cast<size_t>(header_->feed_stats_offset));
+  }
+  if (::mdg::index_dir(base_, header_) && ::mdg::index_entries(base_, header_)) {
+    uint8_t* b = reinterpret_cast<uint8_t*>(base_);
+    index_dir_ = reinterpret_cast<char*>(b + static_cast<size_t>(header_->index_dir_offset));
+    index_entries_ = reinterpret_cast<IndexEntry*>(b + static_cast<size_t>(header_->index_entries_offset));
+  }
   return true;
 }
 
+void ShmWriter::ComputeLayout_(uint32_t symbol_count, const ShmCreateOptions& opts, Layout* out) {
+  // [ header | symbol_dir | symbol_index | snapshot entries | feed stats | (64KB aligned) reader registry |
+  //   mirror controls | mirror entries | (64KB aligned, optional) transaction ring | order ring |
+  //   order queue table | index dir + index entries ]
+  const uint64_t header_bytes = static_cast<uint64_t>(align_up(sizeof(ShmHeader), kCacheLineBytes));
+  out->symbol_dir_offset = header_bytes;
+  out->symbol_dir_bytes = static_cast<uint64_t>(
+      align_up(static_cast<size_t>(symbol_count) * static_cast<size_t>(kSymbolDirEntryBytes), kCacheLineBytes));
+  out->symbol_index_capacity = symbol_index_capacity_for(symbol_count);
+  out->symbol_index_offset = out->symbol_dir_offset + out->symbol_dir_bytes;
+  out->symbol_index_bytes = static_cast<uint64_t>(
+      align_up(static_cast<size_t>(out->symbol_index_capacity) * sizeof(SymbolIndexSlot), kCacheLineBytes));
+  out->snapshot_offset = out->symbol_index_offset + out->symbol_index_bytes;
+  out->snapshot_bytes = static_cast<uint64_t>(symbol_count) * static_cast<uint64_t>(sizeof(SnapshotEntry));
+  out->feed_stats_offset = out->snapshot_offset + out->snapshot_bytes;
+  out->feed_stats_bytes = static_cast<uint64_t>(kMaxFeedStreams) * sizeof(FeedStreamStats);
+  out->reader_registry_offset = static_cast<uint64_t>(
+      align_up(static_cast<size_t>(out->feed_stats_offset + out->feed_stats_bytes), kShmRegionAlignBytes));
+  out->reader_registry_bytes = static_cast<uint64_t>(
+      align_up(static_cast<size_t>(kMaxReaders) * sizeof(ReaderSlot), kShmRegionAlignBytes));
+  out->mirror_ctl_offset = out->reader_registry_offset + out->reader_registry_bytes;
+  out->mirror_ctl_bytes = static_cast<uint64_t>(
+      align_up(static_cast<size_t>(kMaxMirrors) * sizeof(MirrorControl), kShmRegionAlignBytes));
+  out->mirror_entries_offset = out->mirror_ctl_offset + out->mirror_ctl_bytes;
+  out->mirror_entries_bytes =
+      static_cast<uint64_t>(kMaxMirrors) * kMirrorMaxSymbols * static_cast<uint64_t>(sizeof(SnapshotEntry));
+  out->total_bytes = out->mirror_entries_offset + out->mirror_entries_bytes;
+
+  out->event_capacity = 0;
+  out->event_ring_offset = 0;
+  out->event_ring_bytes = 0;
+  if (opts.transaction_ring_capacity != 0) {
+    uint32_t cap = 1;
+    while (cap < opts.transaction_ring_capacity) cap <<= 1;
+    out->event_capacity = cap;
+    out->event_ring_offset =
+        static_cast<uint64_t>(align_up(static_cast<size_t>(out->total_bytes), kShmRegionAlignBytes));
+    out->event_ring_bytes = static_cast<uint64_t>(cap) * sizeof(TransactionSlot);
+    out->total_bytes = out->event_ring_offset + out->event_ring_bytes;
+  }
+
+  out->order_capacity = 0;
+  out->order_ring_offset = 0;
+  out->order_ring_bytes = 0;
+  if (opts.order_ring_capacity != 0) {
+    uint32_t cap = 1;
+    while (cap < opts.order_ring_capacity) cap <<= 1;
+    out->order_capacity = cap;
+    out->order_ring_offset =
+        static_cast<uint64_t>(align_up(static_cast<size_t>(out->total_bytes), kShmRegionAlignBytes));
+    out->order_ring_bytes = static_cast<uint64_t>(cap) * sizeof(OrderSlot);
+    out->total_bytes = out->order_ring_offset + out->order_ring_bytes;
+  }
+
+  out->order_queue_offset = 0;
+  out->order_queue_bytes = 0;
+  if (opts.order_queue_table) {
+    out->order_queue_offset =
+        static_cast<uint64_t>(align_up(static_cast<size_t>(out->total_bytes), kShmRegionAlignBytes));
+    out->order_queue_bytes = static_cast<uint64_t>(symbol_count) * 2 * sizeof(OrderQueueEntry);
+    out->total_bytes = out->order_queue_offset + out->order_queue_bytes;
+  }
+
+  out->index_dir_offset = 0;
+  out->index_dir_bytes = 0;
+  out->index_entries_offset = 0;
+  out->index_entries_bytes = 0;
+  if (opts.index_table) {
+    out->index_dir_offset =
+        static_cast<uint64_t>(align_up(static_cast<size_t>(out->total_bytes), kShmRegionAlignBytes));
+    out->index_dir_bytes = static_cast<uint64_t>(kMaxIndices) * kWindCodeBytes;
+    out->index_entries_offset = out->index_dir_offset + out->index_dir_bytes;
+    out->index_entries_bytes = static_cast<uint64_t>(kMaxIndices) * sizeof(IndexEntry);
+    out->total_bytes = out->index_entries_offset + out->index_entries_bytes;
+  }
+
+  out->l3_book_offset = 0;
+  out->l3_book_bytes = 0;
+  if (opts.l3_book_table) {
+    out->l3_book_offset =
+        static_cast<uint64_t>(align_up(static_cast<size_t>(out->total_bytes), kShmRegionAlignBytes));
+    out->l3_book_bytes = static_cast<uint64_t>(symbol_count) * sizeof(L3BookEntry);
+    out->total_bytes = out->l3_book_offset + out->l3_book_bytes;
+  }
+
+  out->live_trade_offset = 0;
+  out->live_trade_bytes = 0;
+  if (opts.live_trade_table) {
+    out->live_trade_offset =
+        static_cast<uint64_t>(align_up(static_cast<size_t>(out->total_bytes), kShmRegionAlignBytes));
+    out->live_trade_bytes = static_cast<uint64_t>(symbol_count) * sizeof(LiveTradeEntry);
+    out->total_bytes = out->live_trade_offset + out->live_trade_bytes;
+  }
+
+  out->history_depth = 0;
+  out->history_offset = 0;
+  out->history_bytes = 0;
+  if (opts.history_depth != 0) {
+    uint32_t depth = 1;
+    while (depth < opts.history_depth) depth <<= 1;
+    out->history_depth = depth;
+    out->history_offset =
+        static_cast<uint64_t>(align_up(static_cast<size_t>(out->total_bytes), kShmRegionAlignBytes));
+    out->history_bytes = static_cast<uint64_t>(symbol_count) *
+                         (sizeof(HistoryHead) + static_cast<uint64_t>(depth) * sizeof(HistorySlot));
+    out->total_bytes = out->history_offset + out->history_bytes;
+  }
+
+  out->sys_event_offset =
+      static_cast<uint64_t>(align_up(static_cast<size_t>(out->total_bytes), kShmRegionAlignBytes));
+  out->sys_event_bytes = static_cast<uint64_t>(kSysEventCapacity) * sizeof(SystemEventSlot);
+  out->total_bytes = out->sys_event_offset + out->sys_event_bytes;
+
+  out->limit_up_offset = 0;
+  out->limit_up_bytes = 0;
+  if (opts.limit_up_table) {
+    out->limit_up_offset =
+        static_cast<uint64_t>(align_up(static_cast<size_t>(out->total_bytes), kShmRegionAlignBytes));
+    out->limit_up_bytes = static_cast<uint64_t>(symbol_count) * sizeof(LimitUpEntry);
+    out->total_bytes = out->limit_up_offset + out->limit_up_bytes;
+  }
+
+  out->seal_erosion_offset = 0;
+  out->seal_erosion_bytes = 0;
+  if (opts.seal_erosion_table) {
+    out->seal_erosion_offset =
+        static_cast<uint64_t>(align_up(static_cast<size_t>(out->total_bytes), kShmRegionAlignBytes));
+    out->seal_erosion_bytes = static_cast<uint64_t>(symbol_count) * sizeof(SealErosionEntry);
+    out->total_bytes = out->seal_erosion_offset + out->seal_erosion_bytes;
+  }
+}
+
 void ShmWriter::InitHeader_(uint32_t symbol_count, size_t total_bytes) {
   // Fill ABI header.
   ShmHeader* h = header_;
   ::memset(h->magic, 0, sizeof(h->magic));
   const char kMagic[8] = {'M','D','G','A','T','E','1','\0'};
   ::memcpy(h->magic, kMagic, sizeof(kMagic));
-  h->abi_version = 1;
+  h->abi_version = kShmAbiVersion;
   h->header_bytes = static_cast<uint32_t>(sizeof(ShmHeader));
   h->total_bytes = static_cast<uint64_t>(bytes_);
   h->endian = 1; // little
@@ -271,34 +531,126 @@ void ShmWriter::InitHeader_(uint32_t symbol_count, size_t total_bytes) {
 
   h->symbol_count = symbol_count;
   h->symbol_key_type = 1;
-  const uint64_t header_aligned = static_cast<uint64_t>(align_up(sizeof(ShmHeader), kCacheLineBytes));
-  const uint64_t dir_bytes = static_cast<uint64_t>(align_up(static_cast<size_t>(symbol_count) *
-                                                                static_cast<size_t>(kSymbolDirEntryBytes),
-                                                            kCacheLineBytes));
-  h->symbol_dir_offset = header_aligned;
-  h->symbol_dir_bytes = dir_bytes;
-
-  h->snapshot_offset = header_aligned + dir_bytes;
+  h->symbol_dir_offset = layout_.symbol_dir_offset;
+  h->symbol_dir_bytes = layout_.symbol_dir_bytes;
+  h->symbol_index_offset = layout_.symbol_index_offset;
+  h->symbol_index_bytes = layout_.symbol_index_bytes;
+  h->symbol_index_capacity = layout_.symbol_index_capacity;
+  h->symbol_index_reserved = 0;
+
+  h->snapshot_offset = layout_.snapshot_offset;
   h->snapshot_entry_bytes = static_cast<uint32_t>(sizeof(SnapshotEntry));
   h->snapshot_payload_bytes = kMarketDataBytes;
   h->snapshot_mode = 1;
   h->snapshot_bytes = static_cast<uint64_t>(h->snapshot_entry_bytes) * static_cast<uint64_t>(h->symbol_count);
 
-  h->event_ring_offset = 0;
-  h->event_ring_bytes = 0;
-  h->event_slot_bytes = 0;
-  h->event_capacity = 0;
+  h->event_ring_offset = layout_.event_ring_offset;
+  h->event_ring_bytes = layout_.event_ring_bytes;
+  h->event_slot_bytes = (layout_.event_capacity != 0) ? static_cast<uint32_t>(sizeof(TransactionSlot)) : 0;
+  h->event_capacity = layout_.event_capacity;
   store_u64_relaxed(&h->event_write_seq, 0);
 
   store_u32_relaxed(&h->md_status, 2); // RECONNECTING
   store_u32_relaxed(&h->last_err, 0);
   store_u64_relaxed(&h->last_md_ns, 0);
+  store_u64_relaxed(&h->publish_begin, 0);
+  store_u64_relaxed(&h->publish_end, 0);
+
+  h->reader_registry_offset = layout_.reader_registry_offset;
+  h->reader_registry_bytes = layout_.reader_registry_bytes;
+  h->reader_slot_bytes = static_cast<uint32_t>(sizeof(ReaderSlot));
+  h->reader_capacity = kMaxReaders;
+  store_u32_relaxed(&h->reader_active, 0);
+  store_u32_relaxed(&h->reader_max_lag_pid, 0);
+  store_u64_relaxed(&h->reader_max_lag_ns, 0);
+  store_u64_relaxed(&h->reader_reclaimed, 0);
+
+  h->mirror_ctl_offset = layout_.mirror_ctl_offset;
+  h->mirror_ctl_bytes = layout_.mirror_ctl_bytes;
+  h->mirror_entries_offset = layout_.mirror_entries_offset;
+  h->mirror_entries_bytes = layout_.mirror_entries_bytes;
+  h->mirror_capacity = kMaxMirrors;
+  h->mirror_max_symbols = kMirrorMaxSymbols;
+  store_u32_relaxed(&h->mirror_active, 0);
+  h->mirror_reserved = 0;
+  store_u64_relaxed(&h->coalesced_updates, 0);
+  store_u32_relaxed(&h->pending_depth, 0);
+  h->coalesce_reserved = 0;
+
+  h->order_ring_offset = layout_.order_ring_offset;
+  h->order_ring_bytes = layout_.order_ring_bytes;
+  h->order_slot_bytes = (layout_.order_capacity != 0) ? static_cast<uint32_t>(sizeof(OrderSlot)) : 0;
+  h->order_capacity = layout_.order_capacity;
+  store_u64_relaxed(&h->order_write_seq, 0);
+
+  h->order_queue_offset = layout_.order_queue_offset;
+  h->order_queue_bytes = layout_.order_queue_bytes;
+  h->order_queue_entry_bytes = (layout_.order_queue_bytes != 0) ? static_cast<uint32_t>(sizeof(OrderQueueEntry)) : 0;
+  h->order_queue_reserved = 0;
+
+  h->index_dir_offset = layout_.index_dir_offset;
+  h->index_dir_bytes = layout_.index_dir_bytes;
+  h->index_entries_offset = layout_.index_entries_offset;
+  h->index_entries_bytes = layout_.index_entries_bytes;
+  h->index_capacity = (layout_.index_entries_bytes != 0) ? kMaxIndices : 0;
+  store_u32_relaxed(&h->index_count, 0);
+
+  h->feed_stats_offset = layout_.feed_stats_offset;
+  h->feed_stats_bytes = layout_.feed_stats_bytes;
+  h->feed_stats_capacity = kMaxFeedStreams;
+  store_u32_relaxed(&h->feed_stats_count, 0);
+
+  h->l3_book_offset = layout_.l3_book_offset;
+  h->l3_book_bytes = layout_.l3_book_bytes;
+  h->l3_book_entry_bytes = (layout_.l3_book_bytes != 0) ? static_cast<uint32_t>(sizeof(L3BookEntry)) : 0;
+  h->l3_book_levels = (layout_.l3_book_bytes != 0) ? kL3BookLevels : 0;
+
+  h->live_trade_offset = layout_.live_trade_offset;
+  h->live_trade_bytes = layout_.live_trade_bytes;
+  h->live_trade_entry_bytes =
+      (layout_.live_trade_bytes != 0) ? static_cast<uint32_t>(sizeof(LiveTradeEntry)) : 0;
+  h->live_trade_reserved = 0;
+
+  h->history_offset = layout_.history_offset;
+  h->history_bytes = layout_.history_bytes;
+  h->history_depth = layout_.history_depth;
+  h->history_stride_bytes = 0;
+  if (layout_.history_depth != 0) {
+    h->history_stride_bytes = static_cast<uint32_t>(sizeof(HistoryHead) + layout_.history_depth * sizeof(HistorySlot));
+  }
 
-  // Flags: bit0=has_snapshot, bit1=has_symbol_dir
-  h->flags = 1u | 2u;
+  h->sys_event_offset = layout_.sys_event_offset;
+  h->sys_event_bytes = layout_.sys_event_bytes;
+  h->sys_event_capacity = kSysEventCapacity;
+  store_u32_relaxed(&h->market_count, 0);
+  store_u64_relaxed(&h->sys_event_write_seq, 0);
+  ::memset(h->markets, 0, sizeof(h->markets));
+
+  h->limit_up_offset = layout_.limit_up_offset;
+  h->limit_up_bytes = layout_.limit_up_bytes;
+  h->limit_up_entry_bytes = (layout_.limit_up_bytes != 0) ? static_cast<uint32_t>(sizeof(LimitUpEntry)) : 0;
+  h->limit_up_reserved = 0;
+
+  h->seal_erosion_offset = layout_.seal_erosion_offset;
+  h->seal_erosion_bytes = layout_.seal_erosion_bytes;
+  h->seal_erosion_entry_bytes =
+      (layout_.seal_erosion_bytes != 0) ? static_cast<uint32_t>(sizeof(SealErosionEntry)) : 0;
+  h->seal_erosion_windows = (layout_.seal_erosion_bytes != 0) ? kSealWindows : 0;
+
+  h->flags = kShmFlagSnapshot | kShmFlagSymbolDir | kShmFlagSymbolIndex | kShmFlagReaderRegistry |
+             kShmFlagPublishGeneration | kShmFlagMirrors | kShmFlagFeedIntegrity | kShmFlagSystemEvents;
+  if (layout_.event_capacity != 0) h->flags |= kShmFlagTransactionRing;
+  if (layout_.order_capacity != 0) h->flags |= kShmFlagOrderRing;
+  if (layout_.order_queue_bytes != 0) h->flags |= kShmFlagOrderQueue;
+  if (layout_.l3_book_bytes != 0) h->flags |= kShmFlagL3Book;
+  if (layout_.live_trade_bytes != 0) h->flags |= kShmFlagLiveTrade;
+  if (layout_.history_bytes != 0) h->flags |= kShmFlagHistory;
+  if (layout_.limit_up_bytes != 0) h->flags |= kShmFlagLimitUp;
+  if (layout_.seal_erosion_bytes != 0) h->flags |= kShmFlagSealErosion;
+  if (layout_.index_entries_bytes != 0) h->flags |= kShmFlagIndexTable;
 
   // Sanity check (debug): ensure layout matches allocated bytes.
-  const uint64_t calc_total = h->snapshot_offset + h->snapshot_bytes;
+  const uint64_t calc_total = layout_.total_bytes;
   if (calc_total != static_cast<uint64_t>(total_bytes)) {
     // Keep header consistent even if caller ignores this mismatch.
     h->total_bytes = static_cast<uint64_t>(total_bytes);
@@ -313,8 +665,314 @@ void ShmWriter::InitSnapshotTable_(uint32_t symbol_count) {
   for (size_t i = 0; i < n; ++i) {
     store_u32_relaxed(&entries_[i].seq, 0);
     entries_[i].last_update_ns = 0;
+    entries_[i].update_count = 0;
+    store_u32_relaxed(&entries_[i].flags, 0);
     ::memset(&entries_[i].payload, 0, sizeof(entries_[i].payload));
   }
 }
 
+void ShmWriter::PublishSymbolKey_(uint32_t symbol_id, const char* wind_code) {
+  if (!symbol_index_ || !wind_code) return;
+  uint32_t key = 0;
+  if (!parse_wind_code_key(wind_code, &key, nullptr)) return;
+
+  const uint32_t capacity = header_->symbol_index_capacity;
+  const uint32_t mask = capacity - 1;
+  uint32_t i = symbol_key_hash(key) & mask;
+  for (uint32_t n = 0; n < capacity; ++n) {
+    SymbolIndexSlot* s = &symbol_index_[i];
+    const uint32_t k = load_u32_relaxed(&s->key);
+    if (k == key) {
+      s->symbol_id = symbol_id;
+      return;
+    }
+    if (k == kSymbolKeyEmpty) {
+      // id first, key last: readers that observe the key (acquire) also observe the id.
+      s->symbol_id = symbol_id;
+      store_u32_release(&s->key, key);
+      return;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+uint32_t ShmWriter::AddIndex(const char* wind_code) {
+  if (!index_dir_) return kInvalidSymbolId;
+  char canon[kWindCodeBytes];
+  if (!parse_index_code(wind_code, canon)) return kInvalidSymbolId;
+  const uint32_t count = load_u32_relaxed(&header_->index_count);
+  const uint32_t found = index_dir_find(index_dir_, count, canon);
+  if (found != kInvalidSymbolId) return found;
+  if (count >= header_->index_capacity) return kInvalidSymbolId;
+  // Directory entry first, count last: readers that observe the count (acquire) see the code.
+  ::memcpy(index_dir_ + static_cast<size_t>(count) * kWindCodeBytes, canon, kWindCodeBytes);
+  store_u32_release(&header_->index_count, count + 1);
+  return count;
+}
+
+uint32_t ShmWriter::FindIndex(const char* wind_code) const {
+  if (!index_dir_) return kInvalidSymbolId;
+  char canon[kWindCodeBytes];
+  if (!parse_index_code(wind_code, canon)) return kInvalidSymbolId;
+  return index_dir_find(index_dir_, load_u32_acquire(&header_->index_count), canon);
+}
+
+uint32_t ShmWriter::AddFeedStream(uint32_t stream_key) {
+  if (!feed_stats_) return kInvalidSymbolId;
+  const uint32_t count = load_u32_relaxed(&header_->feed_stats_count);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (feed_stats_[i].stream_key == stream_key) return i;
+  }
+  if (count >= header_->feed_stats_capacity) return kInvalidSymbolId;
+  FeedStreamStats* s = &feed_stats_[count];
+  ::memset(s, 0, sizeof(*s));
+  s->stream_key = stream_key;
+  store_u32_release(&header_->feed_stats_count, count + 1);
+  return count;
+}
+
+uint32_t ShmWriter::AddMarket(const char* market) {
+  if (!sys_events_ || !market) return kInvalidSymbolId;
+  char key[sizeof(MarketStatus::market)];
+  ::memset(key, 0, sizeof(key));
+  ::strncpy(key, market, sizeof(key) - 1);
+  const uint32_t count = load_u32_relaxed(&header_->market_count);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (::memcmp(header_->markets[i].v.market, key, sizeof(key)) == 0) return i;
+  }
+  if (count >= kMaxMarkets) return kInvalidSymbolId;
+  MarketStatusEntry* e = &header_->markets[count];
+  ::memset(&e->v, 0, sizeof(e->v));
+  ::memcpy(e->v.market, key, sizeof(key));
+  store_u32_release(&header_->market_count, count + 1);
+  return count;
+}
+
+uint32_t ShmWriter::ScanReaders() {
+  if (!header_ || !readers_) return 0;
+
+  const uint64_t last_md_ns = load_u64_acquire(&header_->last_md_ns);
+  uint32_t active = 0;
+  uint32_t reclaimed = 0;
+  uint32_t max_lag_pid = 0;
+  uint64_t max_lag_ns = 0;
+
+  const uint32_t n = header_->reader_capacity;
+  for (uint32_t i = 0; i < n; ++i) {
+    ReaderSlot* s = &readers_[i];
+    const uint32_t pid = load_u32_acquire(&s->owner_pid);
+    if (pid == 0) continue;
+
+    if (!IsProcessAlive(pid)) {
+      // Clear before releasing ownership so the next owner starts from zero.
+      s->attach_ns = 0;
+      store_u64_relaxed(&s->heartbeat_ns, 0);
+      store_u64_relaxed(&s->cursor_md_ns, 0);
+      store_u64_relaxed(&s->cursor_generation, 0);
+      store_u64_relaxed(&s->cursor_txn_seq, 0);
+      store_u64_relaxed(&s->cursor_order_seq, 0);
+      reader_slot_clear_counters(s);
+      if (cas_u32_acq_rel(&s->owner_pid, pid, 0)) ++reclaimed;
+      continue;
+    }
+
+    ++active;
+    const uint64_t cursor = load_u64_acquire(&s->cursor_md_ns);
+    const uint64_t lag = (last_md_ns > cursor) ? (last_md_ns - cursor) : 0;
+    if (lag > max_lag_ns || max_lag_pid == 0) {
+      max_lag_ns = lag;
+      max_lag_pid = pid;
+    }
+  }
+
+  store_u32_relaxed(&header_->reader_active, active);
+  store_u64_relaxed(&header_->reader_max_lag_ns, max_lag_ns);
+  store_u32_release(&header_->reader_max_lag_pid, max_lag_pid);
+  if (reclaimed) fetch_add_u64_relaxed(&header_->reader_reclaimed, reclaimed);
+  return reclaimed;
+}
+
+void ShmWriter::ResetMirrors_() {
+  mirror_target_begin_.clear();
+  mirror_targets_.clear();
+  for (uint32_t i = 0; i < kMaxMirrors; ++i) {
+    mirror_built_pid_[i] = 0;
+    mirror_built_seq_[i] = 0;
+  }
+  store_u32_relaxed(&mirror_lock_, 0);
+  store_u32_relaxed(&mirror_fanout_, 0);
+}
+
+void ShmWriter::FanOutMirrors_(uint32_t symbol_id, const MarketData320& md, uint64_t now_ns) {
+  while (!cas_u32_acq_rel(&mirror_lock_, 0, 1)) cpu_relax();
+  if (symbol_id + 1 < mirror_target_begin_.size()) {
+    const uint32_t end = mirror_target_begin_[symbol_id + 1];
+    for (uint32_t t = mirror_target_begin_[symbol_id]; t < end; ++t) {
+      SnapshotEntry* m = mirror_targets_[t];
+      const uint32_t odd = seqlock_write_begin(&m->seq);
+      m->last_update_ns = now_ns;
+      ::memcpy(&m->payload, &md, sizeof(MarketData320));
+      seqlock_write_end(&m->seq, odd);
+    }
+  }
+  store_u32_release(&mirror_lock_, 0);
+}
+
+void ShmWriter::FillMirror_(uint32_t mirror, const uint32_t* ids, uint32_t count, uint32_t* src_seqs) {
+  // The mirror is out of the fan-out map: this thread is its only writer, no lock needed.
+  SnapshotEntry* dst = mirror_entries_ + static_cast<size_t>(mirror) * kMirrorMaxSymbols;
+  for (uint32_t pos = 0; pos < count; ++pos) {
+    const uint32_t id = ids[pos];
+    src_seqs[pos] = 0;
+    if (id >= header_->symbol_count) continue;
+    // Another feed thread may be mid-write on the source entry: copy a stable version.
+    MarketData320 md;
+    while (!seqlock_read_once(&entries_[id], &md, &src_seqs[pos])) cpu_relax();
+    SnapshotEntry* m = &dst[pos];
+    const uint32_t odd = seqlock_write_begin(&m->seq);
+    m->last_update_ns = entries_[id].last_update_ns;
+    ::memcpy(&m->payload, &md, sizeof(MarketData320));
+    seqlock_write_end(&m->seq, odd);
+  }
+}
+
+void ShmWriter::CatchUpMirror_(uint32_t mirror, const uint32_t* ids, uint32_t count, const uint32_t* src_seqs) {
+  // Fan-out into the mirror is live again: re-copy entries whose source moved after FillMirror_ (those
+  // updates were not fanned out). The lock is held for one 320B copy, and only if the source is still
+  // the version just read, so a newer fan-out is never overwritten.
+  SnapshotEntry* dst = mirror_entries_ + static_cast<size_t>(mirror) * kMirrorMaxSymbols;
+  for (uint32_t pos = 0; pos < count; ++pos) {
+    const uint32_t id = ids[pos];
+    if (id >= header_->symbol_count) continue;
+    for (;;) {
+      MarketData320 md;
+      uint32_t seq = 0;
+      if (!seqlock_read_once(&entries_[id], &md, &seq)) {
+        cpu_relax();
+        continue;
+      }
+      if (seq == src_seqs[pos]) break;
+      const uint64_t update_ns = entries_[id].last_update_ns;
+      while (!cas_u32_acq_rel(&mirror_lock_, 0, 1)) cpu_relax();
+      const bool same = load_u32_acquire(&entries_[id].seq) == seq;
+      if (same) {
+        SnapshotEntry* m = &dst[pos];
+        const uint32_t odd = seqlock_write_begin(&m->seq);
+        m->last_update_ns = update_ns;
+        ::memcpy(&m->payload, &md, sizeof(MarketData320));
+        seqlock_write_end(&m->seq, odd);
+      }
+      store_u32_release(&mirror_lock_, 0);
+      if (same) break;
+    }
+  }
+}
+
+void ShmWriter::BuildFanOut_(const uint32_t* counts, const uint32_t* ids, uint32_t include_mask,
+                             std::vector<uint32_t>* begin, std::vector<SnapshotEntry*>* targets) const {
+  const uint32_t symbol_count = header_->symbol_count;
+  begin->assign(static_cast<size_t>(symbol_count) + 1, 0);
+  for (uint32_t i = 0; i < kMaxMirrors; ++i) {
+    if ((include_mask & (1u << i)) == 0) continue;
+    const uint32_t* mids = ids + static_cast<size_t>(i) * kMirrorMaxSymbols;
+    for (uint32_t pos = 0; pos < counts[i]; ++pos) {
+      if (mids[pos] < symbol_count) ++(*begin)[mids[pos] + 1];
+    }
+  }
+  for (uint32_t s = 0; s < symbol_count; ++s) (*begin)[s + 1] += (*begin)[s];
+  targets->assign((*begin)[symbol_count], nullptr);
+  std::vector<uint32_t> cursor(begin->begin(), begin->end() - 1);
+  for (uint32_t i = 0; i < kMaxMirrors; ++i) {
+    if ((include_mask & (1u << i)) == 0) continue;
+    const uint32_t* mids = ids + static_cast<size_t>(i) * kMirrorMaxSymbols;
+    SnapshotEntry* dst = mirror_entries_ + static_cast<size_t>(i) * kMirrorMaxSymbols;
+    for (uint32_t pos = 0; pos < counts[i]; ++pos) {
+      if (mids[pos] < symbol_count) (*targets)[cursor[mids[pos]]++] = &dst[pos];
+    }
+  }
+}
+
+void ShmWriter::SwapFanOut_(std::vector<uint32_t>* begin, std::vector<SnapshotEntry*>* targets, uint32_t active) {
+  while (!cas_u32_acq_rel(&mirror_lock_, 0, 1)) cpu_relax();
+  mirror_target_begin_.swap(*begin);
+  mirror_targets_.swap(*targets);
+  store_u32_relaxed(&mirror_fanout_, active);
+  store_u32_release(&mirror_lock_, 0);
+}
+
+uint32_t ShmWriter::ScanMirrors() {
+  static_assert(kMaxMirrors <= 32, "mirror masks are uint32_t");
+  if (!header_ || !mirror_ctl_ || !mirror_entries_) return 0;
+
+  // The reader may rewrite count / ids at any time: each interest set is copied once, right after its
+  // request_seq, and only the copy is used below. A set rewritten mid-copy carries a newer request_seq
+  // and is rebuilt on the next scan.
+  std::vector<uint32_t> ids(static_cast<size_t>(kMaxMirrors) * kMirrorMaxSymbols);
+  uint32_t counts[kMaxMirrors];
+  uint32_t pids[kMaxMirrors];
+  uint32_t seqs[kMaxMirrors];
+  uint32_t changed = 0;
+  uint32_t active_mask = 0;
+  uint32_t rebuild_mask = 0;
+  for (uint32_t i = 0; i < kMaxMirrors; ++i) {
+    MirrorControl* ctl = &mirror_ctl_[i];
+    uint32_t pid = load_u32_acquire(&ctl->owner_pid);
+    if (pid != 0 && !IsProcessAlive(pid)) {
+      if (cas_u32_acq_rel(&ctl->owner_pid, pid, 0)) pid = 0;
+    }
+    pids[i] = pid;
+    seqs[i] = (pid != 0) ? load_u32_acquire(&ctl->request_seq) : 0;
+    if (seqs[i] == 0) pids[i] = 0;  // claimed, interest set not published yet
+    counts[i] = 0;
+    if (pids[i] != 0) {
+      const uint32_t count = ctl->count;
+      counts[i] = (count < kMirrorMaxSymbols) ? count : kMirrorMaxSymbols;
+      ::memcpy(&ids[static_cast<size_t>(i) * kMirrorMaxSymbols], ctl->ids, counts[i] * sizeof(uint32_t));
+      active_mask |= 1u << i;
+    }
+    if (pids[i] != mirror_built_pid_[i] || seqs[i] != mirror_built_seq_[i]) {
+      ++changed;
+      if (pids[i] != 0) rebuild_mask |= 1u << i;
+    }
+  }
+  if (changed == 0) return 0;
+
+  uint32_t active = 0;
+  for (uint32_t i = 0; i < kMaxMirrors; ++i) active += (active_mask >> i) & 1u;
+
+  // 1) Take the mirrors to rebuild out of the fan-out map, 2) fill them with no lock held (the feed
+  // threads keep writing snapshots), 3) swap in the full map, 4) catch up what moved during the fill.
+  // Allocation happens here, never on the hot path.
+  std::vector<uint32_t> begin;
+  std::vector<SnapshotEntry*> targets;
+  if (rebuild_mask != 0) {
+    BuildFanOut_(counts, &ids[0], active_mask & ~rebuild_mask, &begin, &targets);
+    SwapFanOut_(&begin, &targets, active);
+  }
+  std::vector<uint32_t> src_seqs(ids.size(), 0);
+  for (uint32_t i = 0; i < kMaxMirrors; ++i) {
+    if (rebuild_mask & (1u << i)) {
+      const size_t at = static_cast<size_t>(i) * kMirrorMaxSymbols;
+      FillMirror_(i, &ids[at], counts[i], &src_seqs[at]);
+    }
+  }
+  BuildFanOut_(counts, &ids[0], active_mask, &begin, &targets);
+  SwapFanOut_(&begin, &targets, active);
+  for (uint32_t i = 0; i < kMaxMirrors; ++i) {
+    if (rebuild_mask & (1u << i)) {
+      const size_t at = static_cast<size_t>(i) * kMirrorMaxSymbols;
+      CatchUpMirror_(i, &ids[at], counts[i], &src_seqs[at]);
+    }
+  }
+
+  // Acknowledge only after fan-out is live: a reader seeing active_seq == request_seq gets updates.
+  for (uint32_t i = 0; i < kMaxMirrors; ++i) {
+    if (rebuild_mask & (1u << i)) store_u32_release(&mirror_ctl_[i].active_seq, seqs[i]);
+    mirror_built_pid_[i] = pids[i];
+    mirror_built_seq_[i] = seqs[i];
+  }
+  store_u32_release(&header_->mirror_active, active);
+  return changed;
+}
+
 } // namespace mdg
@@ -14,8 +14,23 @@
 #include <string.h>
 #include <assert.h>
 
+#include <vector>
+
 namespace mdg {
 
+// Optional regions sized at Create() time.
+struct ShmCreateOptions {
+  uint32_t transaction_ring_capacity = 0;  // slots, rounded up to a power of two; 0 = no transaction ring
+  uint32_t order_ring_capacity = 0;        // slots, rounded up to a power of two; 0 = no order ring
+  bool order_queue_table = false;          // per-symbol bid/ask OrderQueueEntry table
+  bool index_table = false;                // kMaxIndices IndexEntry slots + directory
+  bool l3_book_table = false;              // per-symbol L3BookEntry table (SZ order book rebuild)
+  bool live_trade_table = false;           // per-symbol LiveTradeEntry overlay (with TRANSACTION)
+  uint32_t history_depth = 0;              // snapshots kept per symbol, rounded up to a power of two; 0 = none
+  bool limit_up_table = false;             // per-symbol LimitUpEntry table
+  bool seal_erosion_table = false;         // per-symbol SealErosionEntry table
+};
+
 class ShmWriter {
 public:
   ShmWriter();
@@ -26,7 +41,7 @@ public:
 
   // Create new SHM (shm_open + ftruncate + mmap) and initialize header/table.
   // Returns false on failure; caller can inspect last_errno().
-  bool Create(const char* shm_name, uint32_t symbol_count);
+  bool Create(const char* shm_name, uint32_t symbol_count, const ShmCreateOptions& opts = ShmCreateOptions());
 
   // Open existing SHM for write (rare; mainly for debug/re-attach).
   bool Open(const char* shm_name);
@@ -41,6 +56,19 @@ public:
   ShmHeader* header() const { return header_; }
   SnapshotEntry* entries() const { return entries_; }
   char* symbol_dir() const { return symbol_dir_; }
+  SymbolIndexSlot* symbol_index() const { return symbol_index_; }
+  ReaderSlot* readers() const { return readers_; }
+  TransactionSlot* transaction_ring() const { return txn_ring_; }
+  OrderSlot* order_ring() const { return order_ring_; }
+  OrderQueueEntry* order_queues() const { return order_queues_; }
+  IndexEntry* index_entries() const { return index_entries_; }
+  FeedStreamStats* feed_stats() const { return feed_stats_; }
+  L3BookEntry* l3_books() const { return l3_books_; }
+  LiveTradeEntry* live_trades() const { return live_trades_; }
+  bool has_history() const { return history_ != nullptr; }
+  SystemEventSlot* sys_events() const { return sys_events_; }
+  LimitUpEntry* limit_ups() const { return limit_ups_; }
+  SealErosionEntry* seal_erosions() const { return seal_erosions_; }
 
   // Hot path: write one symbol snapshot (320B) with seqlock publish.
   // - now_ns: CLOCK_MONOTONIC timestamp from gateway
@@ -52,10 +80,150 @@ public:
     SnapshotEntry* e = &entries_[symbol_id];
     const uint32_t odd = seqlock_write_begin(&e->seq);
     e->last_update_ns = now_ns;
+    ++e->update_count;
     ::memcpy(&e->payload, &md, sizeof(MarketData320));
     seqlock_write_end(&e->seq, odd);
+    if (load_u32_relaxed(&mirror_fanout_) != 0) FanOutMirrors_(symbol_id, md, now_ns);
+  }
+
+  // Sticky per-entry flags (kEntryFlag*); atomic, safe from any gateway thread. Not on the hot path.
+  inline void SetEntryFlags(uint32_t symbol_id, uint32_t bits) {
+    if (header_ && symbol_id < header_->symbol_count) fetch_or_u32_relaxed(&entries_[symbol_id].flags, bits);
+  }
+
+  // Batch bracket around a group of UpdateSnapshot() calls (e.g. one TDF message).
+  // Readers use it for cross-symbol consistent cuts (ShmReader::ReadCut). Safe with concurrent writers.
+  inline void BeginPublish() {
+    fetch_add_u64_acq_rel(&header_->publish_begin, 1);
+    compiler_barrier();
+  }
+  inline void EndPublish() {
+    compiler_barrier();
+    fetch_add_u64_acq_rel(&header_->publish_end, 1);
+  }
+
+  // Hot path, single producer: append one record to the transaction ring (no-op without a ring).
+  // Never waits for readers; slow readers are lapped and detect it (see ring_poll_n).
+  inline void PublishTransaction(const TransactionRecord& rec) {
+    if (txn_ring_) ring_publish(txn_ring_, txn_mask_, &header_->event_write_seq, rec);
+  }
+  // Same for the order ring.
+  inline void PublishOrder(const OrderRecord& rec) {
+    if (order_ring_) ring_publish(order_ring_, order_mask_, &header_->order_write_seq, rec);
+  }
+
+  // Hot path: replace one side's best-price queue (side = kOrderQueueBid / kOrderQueueAsk) with
+  // seqlock publish. Only the first items volumes are copied; items is clamped to kOrderQueueMaxItems.
+  inline void UpdateOrderQueue(uint32_t symbol_id, uint32_t side, int32_t time_hhmmssmmm, int64_t price_x10000,
+                               int32_t orders, const int32_t* volumes, uint32_t items, uint64_t now_ns) {
+    if (!order_queues_ || symbol_id >= header_->symbol_count || side > kOrderQueueAsk) return;
+    if (items > kOrderQueueMaxItems) items = kOrderQueueMaxItems;
+    OrderQueueEntry* q = &order_queues_[static_cast<size_t>(symbol_id) * 2 + side];
+    const uint32_t odd = seqlock_write_begin(&q->seq);
+    q->time_hhmmssmmm = time_hhmmssmmm;
+    q->price_x10000 = price_x10000;
+    q->orders = orders;
+    q->items = static_cast<int32_t>(items);
+    q->last_update_ns = now_ns;
+    ::memcpy(q->volumes, volumes, static_cast<size_t>(items) * sizeof(int32_t));
+    seqlock_write_end(&q->seq, odd);
+  }
+
+  // Hot path: seqlock publish of one symbol's rebuilt book. Level counts are clamped to kL3BookLevels;
+  // only the valid levels are copied.
+  inline void UpdateL3Book(uint32_t symbol_id, const L3BookHead& head, const L3Level* bids, const L3Level* asks) {
+    if (!l3_books_ || symbol_id >= header_->symbol_count) return;
+    L3BookEntry* e = &l3_books_[symbol_id];
+    const uint32_t nb = (head.bid_levels < kL3BookLevels) ? head.bid_levels : kL3BookLevels;
+    const uint32_t na = (head.ask_levels < kL3BookLevels) ? head.ask_levels : kL3BookLevels;
+    const uint32_t odd = seqlock_write_begin(&e->seq);
+    e->head = head;
+    e->head.bid_levels = nb;
+    e->head.ask_levels = na;
+    ::memcpy(e->bids, bids, static_cast<size_t>(nb) * sizeof(L3Level));
+    ::memcpy(e->asks, asks, static_cast<size_t>(na) * sizeof(L3Level));
+    seqlock_write_end(&e->seq, odd);
+  }
+
+  // Hot path: seqlock publish of one symbol's live trade overlay.
+  inline void UpdateLiveTrade(uint32_t symbol_id, const LiveTrade& v) {
+    if (!live_trades_ || symbol_id >= header_->symbol_count) return;
+    LiveTradeEntry* e = &live_trades_[symbol_id];
+    const uint32_t odd = seqlock_write_begin(&e->seq);
+    e->v = v;
+    seqlock_write_end(&e->seq, odd);
+  }
+
+  // Hot path: seqlock publish of one symbol's limit-up state.
+  inline void UpdateLimitUp(uint32_t symbol_id, const LimitUpState& v) {
+    if (!limit_ups_ || symbol_id >= header_->symbol_count) return;
+    LimitUpEntry* e = &limit_ups_[symbol_id];
+    const uint32_t odd = seqlock_write_begin(&e->seq);
+    e->v = v;
+    seqlock_write_end(&e->seq, odd);
+  }
+
+  // Hot path: seqlock publish of one symbol's seal erosion record.
+  inline void UpdateSealErosion(uint32_t symbol_id, const SealErosion& v) {
+    if (!seal_erosions_ || symbol_id >= header_->symbol_count) return;
+    SealErosionEntry* e = &seal_erosions_[symbol_id];
+    const uint32_t odd = seqlock_write_begin(&e->seq);
+    e->v = v;
+    seqlock_write_end(&e->seq, odd);
+  }
+
+  // Hot path: append one snapshot to symbol_id's history ring. Single writer (the callback thread).
+  inline void AppendHistory(uint32_t symbol_id, const HistoryTick& tick) {
+    if (!history_ || symbol_id >= header_->symbol_count) return;
+    HistoryHead* head = reinterpret_cast<HistoryHead*>(history_ + static_cast<size_t>(symbol_id) * history_stride_);
+    ring_publish(reinterpret_cast<HistorySlot*>(head + 1), history_mask_, &head->write_seq, tick);
+  }
+
+  // System callback thread: broadcast one system event on the system event ring.
+  inline void PublishSystemEvent(const SystemEvent& ev) {
+    if (sys_events_) ring_publish(sys_events_, header_->sys_event_capacity - 1, &header_->sys_event_write_seq, ev);
+  }
+
+  // Register a market key (see MarketStatus::market) and return its header.markets index: the
+  // existing one if already registered, kInvalidSymbolId if the block is full or absent.
+  uint32_t AddMarket(const char* market);
+  // Current status of a registered market (the writer's own copy, no seqlock needed to read it).
+  const MarketStatus* market_status(uint32_t market_id) const {
+    return (sys_events_ && market_id < load_u32_relaxed(&header_->market_count)) ? &header_->markets[market_id].v
+                                                                                 : nullptr;
+  }
+  // Seqlock publish of one market's status; v.market is kept as registered.
+  inline void UpdateMarketStatus(uint32_t market_id, const MarketStatus& v) {
+    if (!sys_events_ || market_id >= load_u32_relaxed(&header_->market_count)) return;
+    MarketStatusEntry* e = &header_->markets[market_id];
+    const uint32_t odd = seqlock_write_begin(&e->seq);
+    char market[sizeof(v.market)];
+    ::memcpy(market, e->v.market, sizeof(market));
+    e->v = v;
+    ::memcpy(e->v.market, market, sizeof(market));
+    seqlock_write_end(&e->seq, odd);
+  }
+
+  // Hot path: seqlock publish of one index level.
+  inline void UpdateIndex(uint32_t index_id, int32_t time_hhmmssmmm, const IndexValues& v) {
+    if (!index_entries_ || index_id >= header_->index_capacity) return;
+    IndexEntry* e = &index_entries_[index_id];
+    const uint32_t odd = seqlock_write_begin(&e->seq);
+    e->time_hhmmssmmm = time_hhmmssmmm;
+    e->v = v;
+    seqlock_write_end(&e->seq, odd);
   }
 
+  // Register an index code (see parse_index_code) and return its id: the existing id if already
+  // registered, kInvalidSymbolId if the code is malformed or the table is full. Not on the hot path.
+  uint32_t AddIndex(const char* wind_code);
+  // Index code -> id (canonical lookup in the directory); kInvalidSymbolId if not registered.
+  uint32_t FindIndex(const char* wind_code) const;
+
+  // Claim the next feed stats slot for stream_key (feed_stream_key()) and return its index:
+  // the existing slot if already added, kInvalidSymbolId if the stats region is absent or full.
+  uint32_t AddFeedStream(uint32_t stream_key);
+
   // Update gateway heartbeat (reader health check).
   inline void UpdateHeartbeat(uint64_t now_ns) {
     store_u64_release(&header_->heartbeat_ns, now_ns);
@@ -70,6 +238,7 @@ public:
   inline void SetLastErr(uint32_t err) { store_u32_release(&header_->last_err, err); }
 
   // Publish symbol_dir entry (id -> wind_code). Each entry is kSymbolDirEntryBytes bytes.
+  // Also inserts the packed wind_code key into the SHM symbol index (see parse_wind_code_key).
   // Safe to call after Create() (SHM is writable). Not on the hot path.
   inline void WriteSymbolDirEntry(uint32_t symbol_id, const char* wind_code) {
     if (!header_ || !symbol_dir_) return;
@@ -82,20 +251,120 @@ public:
     for (uint32_t i = 0; i + 1 < kSymbolDirEntryBytes && wind_code[i] != '\0'; ++i) {
       dst[i] = wind_code[i];
     }
+    PublishSymbolKey_(symbol_id, wind_code);
   }
 
+  // Scan the reader registry (non-hot path, call from the heartbeat loop):
+  // - reclaim slots whose owner pid is dead
+  // - publish reader_active / reader_max_lag_ns / reader_max_lag_pid into the header
+  // Returns the number of slots reclaimed by this scan.
+  uint32_t ScanReaders();
+
+  // Scan mirror controls (non-hot path, call from the heartbeat loop next to ScanReaders):
+  // - reclaim mirrors whose owner pid is dead
+  // - for new/changed interest sets: fill the mirror from the table, rebuild the fan-out map,
+  //   then acknowledge (active_seq = request_seq)
+  // Returns the number of mirrors whose state changed.
+  uint32_t ScanMirrors();
+
 private:
+  // Region offsets computed once in Create() and written into the header by InitHeader_().
+  struct Layout {
+    uint64_t symbol_dir_offset;
+    uint64_t symbol_dir_bytes;
+    uint64_t symbol_index_offset;
+    uint64_t symbol_index_bytes;
+    uint32_t symbol_index_capacity;
+    uint64_t snapshot_offset;
+    uint64_t snapshot_bytes;
+    uint64_t reader_registry_offset;
+    uint64_t reader_registry_bytes;
+    uint64_t mirror_ctl_offset;
+    uint64_t mirror_ctl_bytes;
+    uint64_t mirror_entries_offset;
+    uint64_t mirror_entries_bytes;
+    uint64_t event_ring_offset;
+    uint64_t event_ring_bytes;
+    uint32_t event_capacity;
+    uint64_t order_ring_offset;
+    uint64_t order_ring_bytes;
+    uint32_t order_capacity;
+    uint64_t order_queue_offset;
+    uint64_t order_queue_bytes;
+    uint64_t index_dir_offset;
+    uint64_t index_dir_bytes;
+    uint64_t index_entries_offset;
+    uint64_t index_entries_bytes;
+    uint64_t feed_stats_offset;
+    uint64_t feed_stats_bytes;
+    uint64_t l3_book_offset;
+    uint64_t l3_book_bytes;
+    uint64_t live_trade_offset;
+    uint64_t live_trade_bytes;
+    uint64_t history_offset;
+    uint64_t history_bytes;
+    uint32_t history_depth;
+    uint64_t sys_event_offset;
+    uint64_t sys_event_bytes;
+    uint64_t limit_up_offset;
+    uint64_t limit_up_bytes;
+    uint64_t seal_erosion_offset;
+    uint64_t seal_erosion_bytes;
+    uint64_t total_bytes;
+  };
+
+  static void ComputeLayout_(uint32_t symbol_count, const ShmCreateOptions& opts, Layout* out);
   bool MapAndBind_(int fd, size_t bytes, bool init_header);
   void InitHeader_(uint32_t symbol_count, size_t total_bytes);
   void InitSnapshotTable_(uint32_t symbol_count);
+  void PublishSymbolKey_(uint32_t symbol_id, const char* wind_code);
+  void FanOutMirrors_(uint32_t symbol_id, const MarketData320& md, uint64_t now_ns);
+  void FillMirror_(uint32_t mirror, const uint32_t* ids, uint32_t count, uint32_t* src_seqs);
+  void CatchUpMirror_(uint32_t mirror, const uint32_t* ids, uint32_t count, const uint32_t* src_seqs);
+  void BuildFanOut_(const uint32_t* counts, const uint32_t* ids, uint32_t include_mask,
+                    std::vector<uint32_t>* begin, std::vector<SnapshotEntry*>* targets) const;
+  void SwapFanOut_(std::vector<uint32_t>* begin, std::vector<SnapshotEntry*>* targets, uint32_t active);
+  void ResetMirrors_();
 
 private:
   void* base_;
   size_t bytes_;
   ShmHeader* header_;
   char* symbol_dir_;
+  SymbolIndexSlot* symbol_index_;
   SnapshotEntry* entries_;
+  ReaderSlot* readers_;
+  MirrorControl* mirror_ctl_;
+  SnapshotEntry* mirror_entries_;
+  TransactionSlot* txn_ring_;
+  uint64_t txn_mask_;
+  OrderSlot* order_ring_;
+  uint64_t order_mask_;
+  OrderQueueEntry* order_queues_;
+  char* index_dir_;
+  IndexEntry* index_entries_;
+  FeedStreamStats* feed_stats_;
+  L3BookEntry* l3_books_;
+  LiveTradeEntry* live_trades_;
+  uint8_t* history_;
+  size_t history_stride_;
+  uint64_t history_mask_;
+  SystemEventSlot* sys_events_;
+  LimitUpEntry* limit_ups_;
+  SealErosionEntry* seal_erosions_;
   uint32_t create_symbol_count_;
+  Layout layout_;
+
+  // Mirror fan-out map (CSR): mirror entries fed by symbol s are
+  // mirror_targets_[mirror_target_begin_[s] .. mirror_target_begin_[s + 1]).
+  // Rebuilt off the hot path and swapped in under mirror_lock_, which fan-out also holds. Mirrors being
+  // (re)filled are left out of the map, so the fill itself runs without the lock.
+  std::vector<uint32_t> mirror_target_begin_;
+  std::vector<SnapshotEntry*> mirror_targets_;
+  uint32_t mirror_built_pid_[kMaxMirrors];
+  uint32_t mirror_built_seq_[kMaxMirrors];
+  AtomicU32 mirror_lock_;
+  AtomicU32 mirror_fanout_;  // active mirrors; 0 keeps UpdateSnapshot off the lock
 #if defined(_WIN32)
   void* fd_; // HANDLE
 #else
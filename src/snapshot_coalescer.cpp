@@ -0,0 +1,61 @@
+#include "snapshot_coalescer.h"
+
+#include <string.h>
+
+namespace mdg {
+
+SnapshotCoalescer::SnapshotCoalescer()
+    : head_(0), tail_(0), queue_lock_(false), depth_(0), coalesced_(0) {}
+
+void SnapshotCoalescer::Init(uint32_t symbol_count) {
+  pending_.assign(symbol_count, PendingSlot());
+  dirty_.assign(symbol_count, 0);
+  queue_.assign(symbol_count, 0);
+  head_ = 0;
+  tail_ = 0;
+  depth_.store(0, std::memory_order_relaxed);
+  coalesced_.store(0, std::memory_order_relaxed);
+}
+
+bool SnapshotCoalescer::Stage(uint32_t symbol_id, const MarketData320& md, uint64_t now_ns) {
+  if (symbol_id >= dirty_.size()) return false;
+  PendingSlot* p = &pending_[symbol_id];
+  ::memcpy(p->bytes, md.bytes, kMarketDataBytes);
+  p->now_ns = now_ns;
+  if (dirty_[symbol_id]) {
+    coalesced_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  dirty_[symbol_id] = 1;
+
+  // Each id is queued at most once while dirty, so the ring cannot overflow.
+  LockQueue_();
+  queue_[tail_] = symbol_id;
+  tail_ = (tail_ + 1 == queue_.size()) ? 0 : tail_ + 1;
+  depth_.fetch_add(1, std::memory_order_relaxed);
+  UnlockQueue_();
+  return false;
+}
+
+size_t SnapshotCoalescer::Drain(uint32_t* ids, size_t max) {
+  if (depth_.load(std::memory_order_relaxed) == 0) return 0;
+  LockQueue_();
+  size_t n = depth_.load(std::memory_order_relaxed);
+  if (n > max) n = max;
+  for (size_t i = 0; i < n; ++i) {
+    ids[i] = queue_[head_];
+    head_ = (head_ + 1 == queue_.size()) ? 0 : head_ + 1;
+  }
+  depth_.fetch_sub(static_cast<uint32_t>(n), std::memory_order_relaxed);
+  UnlockQueue_();
+  return n;
+}
+
+void SnapshotCoalescer::Take(uint32_t symbol_id, MarketData320* md, uint64_t* now_ns) {
+  const PendingSlot* p = &pending_[symbol_id];
+  ::memcpy(md->bytes, p->bytes, kMarketDataBytes);
+  *now_ns = p->now_ns;
+  dirty_[symbol_id] = 0;
+}
+
+} // namespace mdg
@@ -0,0 +1,70 @@
+#pragma once
+
+// Gateway-side last-value-wins staging between the TDF callback and the SHM writer.
+//
+// Under bursts only the newest snapshot of a symbol matters, so instead of writing every update:
+// - Stage(): copy into the symbol's pending slot; queue the id only if it was clean
+//   (an update for an already-dirty symbol just overwrites the pending payload = coalesced)
+// - publisher thread: Drain() the dirty ids, Take() each pending payload, UpdateSnapshot()
+// The backlog is bounded by the universe size (each id is queued at most once), not the message rate.
+//
+// Locking: Stage() and Take() for a symbol must be called under that symbol's entry lock (the
+// gateway's per-symbol spin lock); the dirty-id queue has its own short spin lock.
+
+#include "struct_def.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <vector>
+
+namespace mdg {
+
+class SnapshotCoalescer {
+public:
+  SnapshotCoalescer();
+
+  SnapshotCoalescer(const SnapshotCoalescer&) = delete;
+  SnapshotCoalescer& operator=(const SnapshotCoalescer&) = delete;
+
+  // Allocates pending slots and the queue for symbol_count ids (not on the hot path).
+  void Init(uint32_t symbol_count);
+
+  // Producer, under the symbol's entry lock. Returns true if a pending update was overwritten.
+  bool Stage(uint32_t symbol_id, const MarketData320& md, uint64_t now_ns);
+
+  // Consumer: moves up to max queued ids into ids (FIFO). Returns the count.
+  size_t Drain(uint32_t* ids, size_t max);
+
+  // Consumer, under the symbol's entry lock: copy out the pending payload and mark the symbol clean,
+  // so the next Stage() queues it again.
+  void Take(uint32_t symbol_id, MarketData320* md, uint64_t* now_ns);
+
+  uint64_t coalesced() const { return coalesced_.load(std::memory_order_relaxed); }
+  uint32_t depth() const { return depth_.load(std::memory_order_relaxed); }
+  uint32_t symbol_count() const { return static_cast<uint32_t>(dirty_.size()); }
+
+private:
+  // Raw bytes, not MarketData320: std::vector does not honour alignas(64) before C++17.
+  struct PendingSlot {
+    uint8_t bytes[kMarketDataBytes];
+    uint64_t now_ns;
+  };
+
+  inline void LockQueue_() {
+    while (queue_lock_.exchange(true, std::memory_order_acquire)) cpu_relax();
+  }
+  inline void UnlockQueue_() { queue_lock_.store(false, std::memory_order_release); }
+
+  std::vector<PendingSlot> pending_;
+  std::vector<uint8_t> dirty_;      // guarded by the entry locks
+  std::vector<uint32_t> queue_;     // ring of dirty ids, capacity = symbol_count
+  size_t head_;
+  size_t tail_;
+  std::atomic<bool> queue_lock_;
+  std::atomic<uint32_t> depth_;
+  std::atomic<uint64_t> coalesced_;
+};
+
+} // namespace mdg
@@ -20,6 +20,7 @@
 
 #if defined(_MSC_VER)
 #include <intrin.h>
+#include <xmmintrin.h>
 #endif
 
 namespace mdg {
@@ -29,6 +30,48 @@ static const uint32_t kMaxSymbols = 3000;
 static const uint32_t kMarketDataBytes = 320;  // 你确认 MarketData 对齐后大小为 320B
 static const uint32_t kWindCodeBytes = 16;     // fixed wind_code buffer (e.g. "600000.SH\0")
 static const uint32_t kSymbolDirEntryBytes = kWindCodeBytes; // id->wind_code directory entry size
+static const uint32_t kInvalidSymbolId = 0xFFFFFFFFu;
+static const uint32_t kSymbolKeyEmpty = 0xFFFFFFFFu; // empty symbol index slot (valid keys are < 2000000)
+static const uint32_t kMaxReaders = 64;        // reader registry slots
+static const uint32_t kMaxMirrors = 16;        // per-reader filtered mirrors
+static const uint32_t kMirrorMaxSymbols = 512; // symbols per mirror
+static const uint32_t kDefaultTransactionRingCapacity = 1u << 20;  // slots (64MB), power of two
+static const uint32_t kDefaultOrderRingCapacity = 1u << 21;        // slots (128MB): orders outpace trades
+static const uint32_t kMaxRingCapacity = 1u << 26;                 // slots per event ring
+static const uint32_t kOrderQueueMaxItems = 200;  // TDF_ORDER_QUEUE::nABVolume
+static const uint32_t kMaxIndices = 256;          // index table capacity
+static const uint32_t kMaxFeedStreams = 64;       // sequence-integrity stats slots
+static const uint32_t kL3BookLevels = 10;         // price levels per side in L3BookEntry
+static const uint32_t kDefaultL3MaxOrders = 1u << 22;  // resting order nodes of the L3 book builder
+static const uint32_t kDefaultHistoryDepth = 256;      // snapshots kept per symbol (~13 min at 3s), power of two
+static const uint32_t kMaxHistoryDepth = 1u << 14;     // history slots per symbol
+static const uint32_t kSysEventCapacity = 1024;        // system event ring slots (64KB), power of two
+static const uint32_t kMaxMarkets = 8;                 // per-market status slots in the header
+// ShmHeader::abi_version. 2: fields added mid-header (symbol index onward); a reader only accepts its
+// own version, so a v1 reader refuses a v2 segment instead of reading shifted offsets.
+static const uint32_t kShmAbiVersion = 2;
+// Regions that readers map writable (reader registry) start at this alignment so they can be mapped
+// separately (Linux needs page alignment, Windows needs allocation-granularity alignment = 64KB).
+static const uint32_t kShmRegionAlignBytes = 65536;
+
+// ShmHeader::flags
+static const uint32_t kShmFlagSnapshot = 1u << 0;
+static const uint32_t kShmFlagSymbolDir = 1u << 1;
+static const uint32_t kShmFlagReaderRegistry = 1u << 2;
+static const uint32_t kShmFlagSymbolIndex = 1u << 3;
+static const uint32_t kShmFlagPublishGeneration = 1u << 4;  // writer brackets batches (publish_begin/end)
+static const uint32_t kShmFlagMirrors = 1u << 5;            // per-reader filtered mirrors
+static const uint32_t kShmFlagTransactionRing = 1u << 6;    // event_ring_* holds TransactionSlot[]
+static const uint32_t kShmFlagOrderRing = 1u << 7;          // order_ring_* holds OrderSlot[]
+static const uint32_t kShmFlagOrderQueue = 1u << 8;         // order_queue_* holds OrderQueueEntry[n][2]
+static const uint32_t kShmFlagIndexTable = 1u << 9;         // index_dir / index_entries (MSG_DATA_INDEX)
+static const uint32_t kShmFlagFeedIntegrity = 1u << 10;     // feed_stats_* + SnapshotEntry::flags
+static const uint32_t kShmFlagL3Book = 1u << 11;            // l3_book_* holds L3BookEntry[symbol_count]
+static const uint32_t kShmFlagLiveTrade = 1u << 12;         // live_trade_* holds LiveTradeEntry[symbol_count]
+static const uint32_t kShmFlagHistory = 1u << 13;           // history_* holds a HistoryHead + HistorySlot ring per symbol
+static const uint32_t kShmFlagSystemEvents = 1u << 14;      // sys_event_* holds SystemEventSlot[] + header.markets
+static const uint32_t kShmFlagLimitUp = 1u << 15;           // limit_up_* holds LimitUpEntry[symbol_count]
+static const uint32_t kShmFlagSealErosion = 1u << 16;       // seal_erosion_* holds SealErosionEntry[symbol_count]
 
 // -------------------------
 // Minimal atomic wrappers (POD) for SHM
@@ -85,6 +128,24 @@ inline uint32_t fetch_add_u32_relaxed(AtomicU32* a, uint32_t d) {
 #endif
 }
 
+inline uint32_t fetch_or_u32_relaxed(AtomicU32* a, uint32_t bits) {
+#if defined(_MSC_VER)
+  return static_cast<uint32_t>(_InterlockedOr(reinterpret_cast<volatile long*>(&a->v), static_cast<long>(bits)));
+#else
+  return __atomic_fetch_or(&a->v, bits, __ATOMIC_RELAXED);
+#endif
+}
+
+inline bool cas_u32_acq_rel(AtomicU32* a, uint32_t expected, uint32_t desired) {
+#if defined(_MSC_VER)
+  return static_cast<uint32_t>(_InterlockedCompareExchange(reinterpret_cast<volatile long*>(&a->v),
+                                                           static_cast<long>(desired),
+                                                           static_cast<long>(expected))) == expected;
+#else
+  return __atomic_compare_exchange_n(&a->v, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
 inline uint64_t load_u64_relaxed(const AtomicU64* a) {
 #if defined(_MSC_VER)
   return a->v;
@@ -123,6 +184,33 @@ inline uint64_t fetch_add_u64_relaxed(AtomicU64* a, uint64_t d) {
 #endif
 }
 
+inline uint64_t fetch_add_u64_acq_rel(AtomicU64* a, uint64_t d) {
+#if defined(_MSC_VER)
+  return static_cast<uint64_t>(
+      _InterlockedExchangeAdd64(reinterpret_cast<volatile long long*>(&a->v), static_cast<long long>(d)));
+#else
+  return __atomic_fetch_add(&a->v, d, __ATOMIC_ACQ_REL);
+#endif
+}
+
+inline void cpu_relax() {
+#if defined(_MSC_VER)
+  _mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+  __asm__ __volatile__("pause" ::: "memory");
+#else
+  // no-op
+#endif
+}
+
+inline void prefetch_ro(const void* p) {
+#if defined(_MSC_VER)
+  _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0);
+#else
+  __builtin_prefetch(p, 0, 3);
+#endif
+}
+
 inline void compiler_barrier() {
 #if defined(_MSC_VER)
   _ReadWriteBarrier();
@@ -147,18 +235,52 @@ struct alignas(kCacheLineBytes) MarketData320 {
 static_assert(sizeof(MarketData320) == kMarketDataBytes, "MarketData320 size mismatch");
 static_assert((kMarketDataBytes % kCacheLineBytes) == 0, "MarketData320 must be cacheline-multiple");
 
+// -------------------------
+// Per-market status (header.markets, kShmFlagSystemEvents)
+// -------------------------
+//
+// One slot per exchange market seen in a TDF system event, in order of first appearance. Kept by
+// the gateway from market events (open / clear / close) and quotation date changes, so a reader can
+// drop its per-day state on a clear or date change without inferring it from snapshot times.
+
+// MarketStatus::state
+static const uint32_t kMarketStateUnknown = 0;
+static const uint32_t kMarketStateCleared = 1;  // market cleared for a new day, not open yet
+static const uint32_t kMarketStateOpen = 2;
+static const uint32_t kMarketStateClosed = 3;
+
+struct MarketStatus {
+  char     market[8];        // market key up to the first '-' ("SH", "SZ"), '\0'-padded
+  uint32_t state;            // kMarketState*
+  int32_t  trading_date;     // yyyymmdd, latest market / quotation date (0 = unknown)
+  int32_t  last_event;       // TDF market event id of the last MSG_SYS_MARKET_EVENT
+  uint32_t clears;           // market clears seen since the gateway started
+  uint32_t date_changes;     // quotation date changes seen since the gateway started
+  uint32_t events;           // system events published for this market
+  int64_t  market_time_ms;   // TDF market_time of the last market event
+  uint64_t last_event_ns;    // gateway monotonic ns of the last event, 0 = none
+};
+
+struct alignas(kCacheLineBytes) MarketStatusEntry {
+  AtomicU32 seq;             // seqlock counter
+  uint32_t _pad0;
+  MarketStatus v;
+};
+
+static_assert(sizeof(MarketStatusEntry) == kCacheLineBytes, "MarketStatusEntry must be one cacheline");
+
 // -------------------------
 // SHM Header (ABI)
 // -------------------------
 //
 // NOTE:
-// - 头部字段尽量保持 fixed layout，新增字段放 reserved。
+// - 头部字段尽量保持 fixed layout，新增字段放 reserved；改动已有字段的偏移必须升 kShmAbiVersion。
 // - heartbeat_ns: writer 周期刷新；reader 用于健康检测/重连。
 
 struct alignas(kCacheLineBytes) ShmHeader {
   // --- ABI / 校验 ---
   char     magic[8];        // "MDGATE1\0"
-  uint32_t abi_version;     // 1
+  uint32_t abi_version;     // kShmAbiVersion
   uint32_t header_bytes;    // sizeof(ShmHeader)
   uint64_t total_bytes;     // total shm bytes
   uint32_t endian;          // 1=little
@@ -177,6 +299,12 @@ struct alignas(kCacheLineBytes) ShmHeader {
   uint64_t symbol_dir_offset;  // 0 means absent
   uint64_t symbol_dir_bytes;   // 0 means absent
 
+  // --- 符号哈希索引（packed wind_code key -> symbol_id，开放寻址/线性探测） ---
+  uint64_t symbol_index_offset;    // 0 means absent
+  uint64_t symbol_index_bytes;
+  uint32_t symbol_index_capacity;  // power of two, >= 2 * symbol_count
+  uint32_t symbol_index_reserved;
+
   // --- 快照表（核心） ---
   uint64_t snapshot_offset;    // offset to snapshot entries[]
   uint64_t snapshot_bytes;     // bytes of snapshot table
@@ -185,18 +313,118 @@ struct alignas(kCacheLineBytes) ShmHeader {
   uint32_t snapshot_mode;      // 1=per-entry seqlock, 2=double-buffer per-entry, ...
   uint32_t reserved0;
 
-  // --- 预留：event ring (未来增量/逐笔) ---
-  uint64_t event_ring_offset;
+  // --- event ring: 逐笔成交广播 (TransactionSlot[event_capacity], see kShmFlagTransactionRing) ---
+  uint64_t event_ring_offset;  // 0 means absent
   uint64_t event_ring_bytes;
-  uint32_t event_slot_bytes;
-  uint32_t event_capacity;
-  AtomicU64 event_write_seq;
+  uint32_t event_slot_bytes;   // sizeof(TransactionSlot)
+  uint32_t event_capacity;     // power of two
+  AtomicU64 event_write_seq;   // last published sequence number (0 = none yet)
 
   // --- 状态 ---
   AtomicU32 md_status;      // 0=OK, 1=DISCONNECTED, 2=RECONNECTING...
   AtomicU32 last_err;       // last error code
   AtomicU64 last_md_ns;     // last marketdata time (monotonic ns)
 
+  // --- publish generation（writer 批次括号，用于跨 symbol 一致性读） ---
+  // publish_begin is incremented before a batch of entry writes, publish_end after it.
+  // begin == end: no batch in flight; generation = publish_end.
+  AtomicU64 publish_begin;
+  AtomicU64 publish_end;
+
+  // --- reader registry（trade_app 在 Open 时认领 slot） ---
+  // Region is kShmRegionAlignBytes-aligned; readers map it writable, the rest stays read-only.
+  uint64_t reader_registry_offset;  // 0 means absent
+  uint64_t reader_registry_bytes;
+  uint32_t reader_slot_bytes;       // sizeof(ReaderSlot)
+  uint32_t reader_capacity;         // kMaxReaders
+  // Aggregates published by the gateway on each registry scan.
+  AtomicU32 reader_active;          // slots owned by a live pid
+  AtomicU32 reader_max_lag_pid;     // pid of the reader with the largest lag (0=none)
+  AtomicU64 reader_max_lag_ns;      // max(last_md_ns - slot.cursor_md_ns) over active slots
+  AtomicU64 reader_reclaimed;       // total slots reclaimed from dead pids
+
+  // --- per-reader filtered mirrors ---
+  // mirror_ctl: kShmRegionAlignBytes-aligned, reader-writable MirrorControl[mirror_capacity]
+  // mirror_entries: SnapshotEntry[mirror_capacity][mirror_max_symbols], gateway-written, dense per mirror
+  uint64_t mirror_ctl_offset;       // 0 means absent
+  uint64_t mirror_ctl_bytes;
+  uint64_t mirror_entries_offset;
+  uint64_t mirror_entries_bytes;
+  uint32_t mirror_capacity;         // kMaxMirrors
+  uint32_t mirror_max_symbols;      // kMirrorMaxSymbols
+  AtomicU32 mirror_active;          // mirrors currently fanned out by the gateway
+  uint32_t mirror_reserved;
+
+  // --- ingest coalescing (gateway --coalesce: last-value-wins per symbol) ---
+  AtomicU64 coalesced_updates;      // updates overwritten in a pending slot before being published
+  AtomicU32 pending_depth;          // dirty symbols waiting for the publisher at the last drain
+  uint32_t coalesce_reserved;
+
+  // --- order ring: 逐笔委托广播 (OrderSlot[order_capacity], same protocol as the event ring) ---
+  uint64_t order_ring_offset;  // 0 means absent
+  uint64_t order_ring_bytes;
+  uint32_t order_slot_bytes;   // sizeof(OrderSlot)
+  uint32_t order_capacity;     // power of two
+  AtomicU64 order_write_seq;   // last published sequence number (0 = none yet)
+
+  // --- order queue table: 最优价委托队列 (OrderQueueEntry[symbol_count][2], bid then ask) ---
+  uint64_t order_queue_offset; // 0 means absent
+  uint64_t order_queue_bytes;
+  uint32_t order_queue_entry_bytes;  // sizeof(OrderQueueEntry)
+  uint32_t order_queue_reserved;
+
+  // --- index table: 指数快照 (index_dir: char[16] per index id, index_entries: IndexEntry[]) ---
+  uint64_t index_dir_offset;   // 0 means absent
+  uint64_t index_dir_bytes;
+  uint64_t index_entries_offset;
+  uint64_t index_entries_bytes;
+  uint32_t index_capacity;     // kMaxIndices
+  AtomicU32 index_count;       // ids [0, index_count) have a directory entry (release after the entry)
+
+  // --- feed integrity: per-stream sequence gap stats (FeedStreamStats[feed_stats_capacity]) ---
+  uint64_t feed_stats_offset;  // 0 means absent
+  uint64_t feed_stats_bytes;
+  uint32_t feed_stats_capacity;  // kMaxFeedStreams
+  AtomicU32 feed_stats_count;    // slots [0, count) in use (release after the slot's stream_key)
+
+  // --- L3 book table: 深市逐笔重建的盘口 (L3BookEntry[symbol_count]) ---
+  uint64_t l3_book_offset;     // 0 means absent
+  uint64_t l3_book_bytes;
+  uint32_t l3_book_entry_bytes;  // sizeof(L3BookEntry)
+  uint32_t l3_book_levels;       // kL3BookLevels
+
+  // --- live trade overlay: 逐笔成交合成的最新价/成交量 (LiveTradeEntry[symbol_count]) ---
+  uint64_t live_trade_offset;  // 0 means absent
+  uint64_t live_trade_bytes;
+  uint32_t live_trade_entry_bytes;  // sizeof(LiveTradeEntry)
+  uint32_t live_trade_reserved;
+
+  // --- snapshot history: 每个代码最近 N 笔快照 (per symbol: HistoryHead + HistorySlot[history_depth]) ---
+  uint64_t history_offset;     // 0 means absent
+  uint64_t history_bytes;
+  uint32_t history_depth;         // slots per symbol, power of two
+  uint32_t history_stride_bytes;  // bytes per symbol = sizeof(HistoryHead) + depth * sizeof(HistorySlot)
+
+  // --- system events: 市场/系统事件广播 (SystemEventSlot[sys_event_capacity]) + 各市场状态 ---
+  uint64_t sys_event_offset;   // 0 means absent
+  uint64_t sys_event_bytes;
+  uint32_t sys_event_capacity;   // kSysEventCapacity
+  AtomicU32 market_count;        // markets[0, count) in use (release after the slot's market key)
+  AtomicU64 sys_event_write_seq; // last published sequence number (0 = none yet)
+  MarketStatusEntry markets[kMaxMarkets];
+
+  // --- limit-up state: 涨停封板/炸板状态 (LimitUpEntry[symbol_count]) ---
+  uint64_t limit_up_offset;    // 0 means absent
+  uint64_t limit_up_bytes;
+  uint32_t limit_up_entry_bytes;  // sizeof(LimitUpEntry)
+  uint32_t limit_up_reserved;
+
+  // --- seal erosion: 封单消耗速度 (SealErosionEntry[symbol_count]) ---
+  uint64_t seal_erosion_offset;  // 0 means absent
+  uint64_t seal_erosion_bytes;
+  uint32_t seal_erosion_entry_bytes;  // sizeof(SealErosionEntry)
+  uint32_t seal_erosion_windows;      // kSealWindows
+
   uint64_t reserved[8];
 };
 
@@ -213,14 +441,707 @@ struct alignas(kCacheLineBytes) SnapshotEntry {
   AtomicU32 seq;            // seqlock counter
   uint32_t _pad0;
   uint64_t last_update_ns;  // writer-stamped monotonic ns (optional)
-  uint8_t  meta_pad[48];    // pad meta to 64B
+  uint64_t update_count;    // UpdateSnapshot calls since Create (feeds the gateway's id layout pass)
+  AtomicU32 flags;          // kEntryFlag* (sticky, set outside the seqlock)
+  uint32_t _pad1;
+  uint8_t  meta_pad[32];    // pad meta to 64B
 
   MarketData320 payload;    // 320B
 };
 
+// SnapshotEntry::flags: derived state for this symbol may be unreliable since the bit was set.
+static const uint32_t kEntryFlagTickGap = 1u << 0;  // a tick-by-tick stream carrying the symbol lost records
+
 static_assert(offsetof(SnapshotEntry, payload) == kCacheLineBytes, "payload must be cacheline-aligned");
 static_assert(sizeof(SnapshotEntry) == (kCacheLineBytes + kMarketDataBytes), "SnapshotEntry size mismatch");
 
+// -------------------------
+// Symbol key + hash index
+// -------------------------
+//
+// Packed key: market * 1000000 + code, market 1=SH, 0=SZ (e.g. "600000.SH" -> 1600000).
+// Accepts exactly 6 digits, '.', then 'S' + {'H'|'Z'} (case-insensitive).
+// out_wind16 (optional) receives the canonical upper-case "NNNNNN.SH\0".
+
+inline bool parse_wind_code_key(const char* wind_code, uint32_t* out_key, char* out_wind16) {
+  if (!wind_code || !out_key) return false;
+
+  uint32_t code = 0;
+  for (int i = 0; i < 6; ++i) {
+    const char c = wind_code[i];
+    if (c < '0' || c > '9') return false;
+    code = code * 10u + static_cast<uint32_t>(c - '0');
+  }
+  if (wind_code[6] != '.') return false;
+  const char m0 = wind_code[7];
+  const char m1 = wind_code[8];
+  if (m0 != 'S' && m0 != 's') return false;
+
+  uint32_t market = 0;
+  if (m1 == 'H' || m1 == 'h') market = 1;
+  else if (m1 == 'Z' || m1 == 'z') market = 0;
+  else return false;
+
+  *out_key = market * 1000000u + code;
+
+  if (out_wind16) {
+    ::memset(out_wind16, 0, kWindCodeBytes);
+    ::memcpy(out_wind16, wind_code, 6);
+    out_wind16[6] = '.';
+    out_wind16[7] = 'S';
+    out_wind16[8] = (market == 1) ? 'H' : 'Z';
+  }
+  return true;
+}
+
+// Index slot: key == kSymbolKeyEmpty means empty. Writer stores symbol_id first, then key (release).
+struct SymbolIndexSlot {
+  AtomicU32 key;
+  uint32_t  symbol_id;
+};
+
+static_assert(sizeof(SymbolIndexSlot) == 8, "SymbolIndexSlot size mismatch");
+
+inline uint32_t symbol_key_hash(uint32_t key) {
+  // lowbias32 finalizer: decimal codes are clustered, so mix before masking.
+  key ^= key >> 16;
+  key *= 0x7feb352du;
+  key ^= key >> 15;
+  key *= 0x846ca68bu;
+  key ^= key >> 16;
+  return key;
+}
+
+inline uint32_t symbol_index_capacity_for(uint32_t symbol_count) {
+  uint32_t cap = 16;
+  while (cap < symbol_count * 2u) cap <<= 1;
+  return cap;
+}
+
+// Probe the index; returns kInvalidSymbolId if absent. No allocation, no locks.
+inline uint32_t symbol_index_find(const SymbolIndexSlot* slots, uint32_t capacity, uint32_t key) {
+  const uint32_t mask = capacity - 1;
+  uint32_t i = symbol_key_hash(key) & mask;
+  for (uint32_t n = 0; n < capacity; ++n) {
+    const uint32_t k = load_u32_acquire(&slots[i].key);
+    if (k == key) return slots[i].symbol_id;
+    if (k == kSymbolKeyEmpty) return kInvalidSymbolId;
+    i = (i + 1) & mask;
+  }
+  return kInvalidSymbolId;
+}
+
+// -------------------------
+// Reader registry slot
+// -------------------------
+//
+// One slot per attached ShmReader:
+// - owner_pid: 0=free; a reader claims a slot by CAS 0 -> getpid()
+// - the reader is the only writer of its slot while it owns it
+// - the gateway only reads slots, except reclaiming slots whose owner pid is dead
+// Counters are accumulated locally by the reader and flushed on ShmReader::Heartbeat().
+
+// Reader histograms (log-scale so one slot covers spin noise up to a stalled feed).
+// retry buckets: 0, 1, 2-3, 4-7, 8-15, 16-31, 32-63, >=64 retries
+// stale buckets: <1us, <10us, <100us, <1ms, <10ms, <100ms, <1s, >=1s
+static const uint32_t kReaderRetryBuckets = 8;
+static const uint32_t kReaderStaleBuckets = 8;
+
+inline uint32_t reader_retry_bucket(uint32_t retries) {
+  uint32_t b = 0;
+  while (retries != 0 && b < kReaderRetryBuckets - 1) {
+    retries >>= 1;
+    ++b;
+  }
+  return b;
+}
+
+inline uint32_t reader_stale_bucket(uint64_t stale_ns) {
+  uint32_t b = 0;
+  uint64_t limit = 1000;
+  while (stale_ns >= limit && b < kReaderStaleBuckets - 1) {
+    limit *= 10;
+    ++b;
+  }
+  return b;
+}
+
+struct alignas(kCacheLineBytes) ReaderSlot {
+  // --- identity / liveness (cacheline 0) ---
+  AtomicU32 owner_pid;
+  uint32_t  _pad0;
+  uint64_t  attach_ns;        // monotonic ns at claim
+  AtomicU64 heartbeat_ns;     // monotonic ns of the last ShmReader::Heartbeat()
+  AtomicU64 cursor_md_ns;     // header.last_md_ns observed at the last heartbeat
+  AtomicU64 cursor_generation;  // last publish generation returned by ShmReader::ReadCut
+  AtomicU64 cursor_txn_seq;   // last transaction ring seq consumed by ShmReader::PollTransactions
+  AtomicU64 cursor_order_seq; // last order ring seq consumed by ShmReader::PollOrders
+  uint8_t   cursor_pad[8];    // reserved for further cursors
+
+  // --- read counters (cacheline 1) ---
+  AtomicU64 reads_ok;
+  AtomicU64 read_retries;     // total seqlock retries (sum over reads)
+  AtomicU64 read_failures;    // reads that gave up (any reason)
+  AtomicU64 torn_reads;       // successful reads that saw at least one torn attempt
+  AtomicU64 retry_exceeded;   // failures with the seq still moving (write contention)
+  AtomicU64 writer_stuck;     // failures with the seq parked at one odd value
+  AtomicU64 stale_samples;    // reads sampled for staleness
+  AtomicU64 stale_max_ns;     // max sampled staleness
+
+  // --- histograms (cachelines 2-3), see reader_retry_bucket / reader_stale_bucket ---
+  AtomicU64 retry_hist[kReaderRetryBuckets];   // retries per successful read
+  AtomicU64 stale_hist[kReaderStaleBuckets];   // now - entry.last_update_ns at read time
+};
+
+static_assert(sizeof(ReaderSlot) == 4 * kCacheLineBytes, "ReaderSlot size mismatch");
+
+// Zero every counter/histogram of a slot (on claim and on reclaim).
+inline void reader_slot_clear_counters(ReaderSlot* s) {
+  store_u64_relaxed(&s->reads_ok, 0);
+  store_u64_relaxed(&s->read_retries, 0);
+  store_u64_relaxed(&s->read_failures, 0);
+  store_u64_relaxed(&s->torn_reads, 0);
+  store_u64_relaxed(&s->retry_exceeded, 0);
+  store_u64_relaxed(&s->writer_stuck, 0);
+  store_u64_relaxed(&s->stale_samples, 0);
+  store_u64_relaxed(&s->stale_max_ns, 0);
+  for (uint32_t i = 0; i < kReaderRetryBuckets; ++i) store_u64_relaxed(&s->retry_hist[i], 0);
+  for (uint32_t i = 0; i < kReaderStaleBuckets; ++i) store_u64_relaxed(&s->stale_hist[i], 0);
+}
+
+// -------------------------
+// Filtered mirror control
+// -------------------------
+//
+// A reader registers an interest set (symbol ids in its own order); the gateway then keeps
+// mirror_entries[mirror][i] == entries[ids[i]] (same seqlock protocol), so the reader streams a
+// dense array instead of striding across the whole table.
+// - reader: CAS owner_pid 0 -> getpid(), write count/ids, then bump request_seq (release)
+// - gateway (mirror scan): fill the mirror, start fan-out, then store active_seq = request_seq
+// - reader releases by storing owner_pid = 0; the gateway reclaims mirrors of dead pids
+// Ids >= symbol_count are kept in place but never updated.
+
+struct alignas(kCacheLineBytes) MirrorControl {
+  AtomicU32 owner_pid;
+  AtomicU32 request_seq;  // reader: interest set version
+  AtomicU32 active_seq;   // gateway: request_seq the fan-out currently follows
+  uint32_t  count;        // <= kMirrorMaxSymbols
+  uint8_t   ctl_pad[48];
+
+  uint32_t  ids[kMirrorMaxSymbols];
+};
+
+static_assert(sizeof(MirrorControl) == kCacheLineBytes + kMirrorMaxSymbols * sizeof(uint32_t),
+              "MirrorControl size mismatch");
+
+// -------------------------
+// SPMC broadcast ring
+// -------------------------
+//
+// One writer, any number of readers each holding its own RingCursor; the writer never waits for
+// readers. Slot is any struct { AtomicU64 seq; Record rec; } in a power-of-two array, plus one
+// AtomicU64 write_seq (last published sequence number) next to it in the header.
+// - sequence numbers start at 1; record seq lives in slots[seq & (capacity - 1)]
+// - writer: slot.seq = 0, copy record, slot.seq = seq (release), write_seq = seq (release)
+// - reader at cursor c <= write_seq: slot.seq must equal c before and after the copy; anything else
+//   means the slot was reused for c + capacity (lapped). The cursor then jumps to the oldest record
+//   still held and counts what it skipped, so a slow reader costs itself records, never the writer.
+// - the oldest record safe to read is write_seq + 2 - capacity: the slot of write_seq + 1 - capacity
+//   may be the one being rewritten
+// Resume after falling behind: re-read the state the records describe (e.g. the snapshot table),
+// then ring_seek(..., from_oldest = false) and tail from there.
+
+// Position of one consumer in a broadcast ring. Process-local; each consumer owns its own cursor.
+struct RingCursor {
+  uint64_t next_seq;  // next sequence number to read
+  uint64_t lost;      // records skipped because the writer lapped this cursor
+  uint64_t overruns;  // times the cursor was lapped
+  uint32_t epoch;     // ShmReader::epoch() the cursor was positioned in (unused by the ring_* helpers)
+};
+
+inline uint64_t ring_oldest_seq(uint64_t head, uint64_t capacity) {
+  return (head + 2 > capacity) ? head + 2 - capacity : 1;
+}
+
+// Writer, single producer.
+template <typename Slot, typename Record>
+inline void ring_publish(Slot* ring, uint64_t mask, AtomicU64* write_seq, const Record& rec) {
+  const uint64_t seq = load_u64_relaxed(write_seq) + 1;
+  Slot* s = &ring[seq & mask];
+  store_u64_relaxed(&s->seq, 0);
+  compiler_barrier();
+  s->rec = rec;
+  store_u64_release(&s->seq, seq);
+  store_u64_release(write_seq, seq);
+}
+
+// Position c at the next record to be published (from_oldest = false) or at the oldest record the
+// ring still holds. Resets c->lost / c->overruns; c->epoch is left to the caller.
+inline void ring_seek(uint64_t capacity, const AtomicU64* write_seq, RingCursor* c, bool from_oldest) {
+  c->lost = 0;
+  c->overruns = 0;
+  c->next_seq = 1;
+  if (!write_seq) return;
+  const uint64_t head = load_u64_acquire(write_seq);
+  c->next_seq = from_oldest ? ring_oldest_seq(head, capacity) : head + 1;
+}
+
+// Records published but not yet consumed by c (may exceed capacity once c was lapped).
+inline uint64_t ring_lag(const AtomicU64* write_seq, const RingCursor* c) {
+  const uint64_t head = load_u64_acquire(write_seq);
+  return (head >= c->next_seq) ? head + 1 - c->next_seq : 0;
+}
+
+// Batch consume: copy up to max records from c onward into out (ring order), returns the count.
+template <typename Slot, typename Record>
+inline size_t ring_poll_n(const Slot* ring, uint64_t capacity, const AtomicU64* write_seq, RingCursor* c,
+                          Record* out, size_t max) {
+  const uint64_t mask = capacity - 1;
+  uint64_t head = load_u64_acquire(write_seq);
+  size_t n = 0;
+  while (n < max && c->next_seq <= head) {
+    const uint64_t seq = c->next_seq;
+    const Slot* s = &ring[seq & mask];
+    if (load_u64_acquire(&s->seq) == seq) {
+      compiler_barrier();
+      out[n] = s->rec;
+      compiler_barrier();
+      if (load_u64_acquire(&s->seq) == seq) {
+        ++n;
+        c->next_seq = seq + 1;
+        continue;
+      }
+    }
+    // Lapped: the slot already holds (or is being rewritten with) seq + capacity.
+    head = load_u64_acquire(write_seq);
+    const uint64_t oldest = ring_oldest_seq(head, capacity);
+    if (oldest > seq) {
+      c->lost += oldest - seq;
+      c->next_seq = oldest;
+    } else {
+      c->lost += 1;  // cannot happen with a well-behaved writer; never spin on one slot
+      c->next_seq = seq + 1;
+    }
+    ++c->overruns;
+  }
+  return n;
+}
+
+// -------------------------
+// Transaction ring (MSG_DATA_TRANSACTION broadcast)
+// -------------------------
+//
+// Fixed 64B slots on the SPMC broadcast ring above, written by the gateway's TDF data callback;
+// header.event_write_seq is the ring's write_seq.
+// Prices are x10000 as in the snapshot payload; symbol_id replaces TDF's pCodeInfo.
+
+struct TransactionRecord {
+  uint32_t symbol_id;
+  int32_t  time_hhmmssmmm;
+  int32_t  index;           // nIndex: trade number within the channel
+  int32_t  channel;         // nChannel
+  int64_t  price_x10000;
+  int64_t  turnover;
+  int64_t  biz_index;       // nBizIndex
+  int32_t  volume;
+  int32_t  ask_order;       // nAskOrder
+  int32_t  bid_order;       // nBidOrder
+  char     bs_flag;         // 'B' / 'S' / ' ' (nBSFlag)
+  char     order_kind;      // chOrderKind
+  char     function_code;   // chFunctionCode (SZ: 'C' = cancel)
+  char     _pad0;
+};
+
+struct alignas(kCacheLineBytes) TransactionSlot {
+  AtomicU64 seq;            // 0 = empty or being rewritten
+  TransactionRecord rec;
+};
+
+static_assert(sizeof(TransactionRecord) == 56, "TransactionRecord size mismatch");
+static_assert(sizeof(TransactionSlot) == kCacheLineBytes, "TransactionSlot must be one cacheline");
+
+// Order ring (MSG_DATA_ORDER): separate ring and capacity, same slot protocol as the transaction ring.
+
+struct OrderRecord {
+  uint32_t symbol_id;
+  int32_t  time_hhmmssmmm;
+  int32_t  order_no;        // nOrder
+  int32_t  channel;         // nChannel
+  int64_t  price_x10000;
+  int64_t  orig_order_no;   // nOrderOriNo (SH: exchange order number)
+  int64_t  biz_index;       // nBizIndex
+  int32_t  volume;
+  char     order_kind;      // chOrderKind
+  char     function_code;   // chFunctionCode ('B' / 'S' / 'C')
+  char     _pad0[10];
+};
+
+struct alignas(kCacheLineBytes) OrderSlot {
+  AtomicU64 seq;            // 0 = empty or being rewritten
+  OrderRecord rec;
+};
+
+static_assert(sizeof(OrderRecord) == 56, "OrderRecord size mismatch");
+static_assert(sizeof(OrderSlot) == kCacheLineBytes, "OrderSlot must be one cacheline");
+
+// -------------------------
+// Order queue table (MSG_DATA_ORDERQUEUE)
+// -------------------------
+//
+// Per symbol, per side: the per-order volumes queued at the best price (the seal queue at limit-up).
+// Same seqlock protocol as SnapshotEntry; the meta cacheline is read on its own, so a reader asking
+// for the first N volumes touches 1 + ceil(4N / 64) cachelines instead of the whole entry.
+
+static const uint32_t kOrderQueueBid = 0;
+static const uint32_t kOrderQueueAsk = 1;
+
+struct alignas(kCacheLineBytes) OrderQueueEntry {
+  AtomicU32 seq;            // seqlock counter
+  int32_t  time_hhmmssmmm;
+  int64_t  price_x10000;
+  int32_t  orders;          // nOrders: orders at the price
+  int32_t  items;           // nABItems: valid volumes[] entries (<= kOrderQueueMaxItems)
+  uint64_t last_update_ns;
+  uint8_t  meta_pad[32];
+
+  int32_t  volumes[kOrderQueueMaxItems];  // nABVolume, queue order
+};
+
+static_assert(offsetof(OrderQueueEntry, volumes) == kCacheLineBytes, "volumes must be cacheline-aligned");
+static_assert(sizeof(OrderQueueEntry) == 14 * kCacheLineBytes, "OrderQueueEntry size mismatch");
+
+// -------------------------
+// Index table (MSG_DATA_INDEX)
+// -------------------------
+//
+// Index levels (000001.SH, 399001.SZ, 000300.SH, ...) live apart from the stock table: own ids, own
+// directory of canonical codes (see parse_index_code), one 64B seqlocked entry per index.
+// Values are x10000 as delivered by TDF (nLastIndex etc.).
+
+struct IndexValues {
+  int64_t open_x10000;
+  int64_t high_x10000;
+  int64_t low_x10000;
+  int64_t last_x10000;
+  int64_t pre_close_x10000;
+  int64_t volume;
+  int64_t turnover;
+};
+
+struct alignas(kCacheLineBytes) IndexEntry {
+  AtomicU32 seq;            // seqlock counter
+  int32_t  time_hhmmssmmm;
+  IndexValues v;
+};
+
+static_assert(sizeof(IndexEntry) == kCacheLineBytes, "IndexEntry must be one cacheline");
+
+// -------------------------
+// L3 book table (SZ order-by-order reconstruction)
+// -------------------------
+//
+// The gateway replays SZ tick-by-tick orders and trades/cancels into a per-symbol book
+// (L3BookBuilder) and publishes the top kL3BookLevels levels per side after every message that
+// touched the symbol, i.e. sub-second instead of the 3s snapshot depth. Same seqlock protocol as
+// SnapshotEntry; the head cacheline can be read on its own.
+
+// L3BookHead::flags
+static const uint32_t kL3BookValid = 1u << 0;       // ladder sized from the price limits, levels are live
+static const uint32_t kL3BookIncomplete = 1u << 1;  // some orders could not be placed (see L3BookBuilder)
+
+struct L3Level {
+  int64_t price_x10000;
+  int64_t volume;
+  int32_t orders;           // resting orders at the price
+  int32_t _pad0;
+};
+
+struct L3BookHead {
+  int32_t  time_hhmmssmmm;  // last applied order / trade
+  uint32_t flags;           // kL3Book*
+  uint32_t bid_levels;      // valid bids[] entries, best first
+  uint32_t ask_levels;      // valid asks[] entries, best first
+  uint32_t live_orders;     // resting orders of the symbol
+  uint32_t _pad0;
+  uint64_t last_appl_seq;   // ApplSeqNum of the last applied record
+  uint64_t last_update_ns;  // gateway monotonic ns, 0 = never published
+};
+
+struct alignas(kCacheLineBytes) L3BookEntry {
+  AtomicU32 seq;            // seqlock counter
+  uint32_t _pad0;
+  L3BookHead head;
+  uint8_t  meta_pad[16];
+
+  L3Level  bids[kL3BookLevels];
+  L3Level  asks[kL3BookLevels];
+};
+
+static_assert(sizeof(L3Level) == 24, "L3Level size mismatch");
+static_assert(offsetof(L3BookEntry, bids) == kCacheLineBytes, "bids must be cacheline-aligned");
+static_assert(sizeof(L3BookEntry) == 9 * kCacheLineBytes, "L3BookEntry size mismatch");
+
+// -------------------------
+// Live trade overlay (MSG_DATA_TRANSACTION folded between snapshots)
+// -------------------------
+//
+// Per symbol: last price, cumulative volume / turnover and last trade time, advanced by every trade
+// and re-based on every snapshot (LiveTradeOverlay), so the totals stay snapshot-consistent while
+// moving at trade frequency. ShmReader::ReadSnapshotLive() applies it over the snapshot.
+
+// LiveTrade::flags
+static const uint32_t kLiveTradeBased = 1u << 0;  // re-based on at least one snapshot
+static const uint32_t kLiveTradeExact = 1u << 1;  // last re-base found the trade totals at the snapshot time
+
+struct LiveTrade {
+  int32_t  time_hhmmssmmm;  // last trade, or the snapshot if newer
+  int32_t  snapshot_time;   // nTime of the snapshot last re-based on
+  int64_t  last_x10000;
+  int64_t  volume;          // cumulative, same basis as MarketDataPayloadV1::volume
+  int64_t  turnover;
+  uint32_t trades;          // trades folded since the last snapshot
+  uint32_t flags;           // kLiveTrade*
+  uint64_t last_update_ns;  // gateway monotonic ns, 0 = never published
+};
+
+struct alignas(kCacheLineBytes) LiveTradeEntry {
+  AtomicU32 seq;            // seqlock counter
+  uint32_t _pad0;
+  LiveTrade v;
+};
+
+static_assert(sizeof(LiveTradeEntry) == kCacheLineBytes, "LiveTradeEntry must be one cacheline");
+
+// -------------------------
+// Snapshot history (last N snapshots per symbol)
+// -------------------------
+//
+// One SPMC broadcast ring per symbol (see above): HistoryHead holds the ring's write_seq, followed by
+// history_depth slots. Every snapshot the gateway receives is appended in compact form (top of book
+// and cumulative totals), independent of --coalesce, so readers get short-horizon series (price
+// velocity, volume surges) without caching snapshots themselves.
+// Prices are narrowed to 32 bits (x10000, enough for any price below 214748; history_price() saturates).
+
+struct HistoryTick {
+  int32_t time_hhmmssmmm;
+  int32_t last_x10000;
+  int32_t high_x10000;
+  int32_t low_x10000;
+  int32_t bid1_x10000;
+  int32_t ask1_x10000;
+  int64_t volume;           // cumulative, same basis as MarketDataPayloadV1::volume
+  int64_t turnover;
+  int64_t bid1_vol;
+  int64_t ask1_vol;
+};
+
+struct alignas(kCacheLineBytes) HistoryHead {
+  AtomicU64 write_seq;      // ticks appended so far (ring write_seq)
+  uint8_t _pad[56];
+};
+
+struct alignas(kCacheLineBytes) HistorySlot {
+  AtomicU64 seq;            // 0 while being written
+  HistoryTick rec;
+};
+
+inline int32_t history_price(int64_t x10000) {
+  if (x10000 > 0x7FFFFFFF) return 0x7FFFFFFF;
+  if (x10000 < 0) return 0;
+  return static_cast<int32_t>(x10000);
+}
+
+static_assert(sizeof(HistoryTick) == 56, "HistoryTick size mismatch");
+static_assert(sizeof(HistoryHead) == kCacheLineBytes, "HistoryHead must be one cacheline");
+static_assert(sizeof(HistorySlot) == kCacheLineBytes, "HistorySlot must be one cacheline");
+
+// -------------------------
+// System event ring (TDF system messages)
+// -------------------------
+//
+// Market events, quotation date changes, market close, added codes and tick size changes as typed
+// records on the SPMC broadcast ring above (header.sys_event_write_seq), written by the gateway's
+// TDF system callback. header.markets holds the resulting per-market state.
+
+// SystemEvent::type
+static const uint32_t kSysEventMarket = 1;      // MSG_SYS_MARKET_EVENT: code = TDF event id, date = market date
+static const uint32_t kSysEventDateChange = 2;  // MSG_SYS_QUOTATIONDATE_CHANGE: date = new, aux = old date
+static const uint32_t kSysEventMarketClose = 3; // MSG_SYS_MARKET_CLOSE: aux = HHMMSSmmm
+static const uint32_t kSysEventAddCode = 4;     // MSG_SYS_ADDCODE: date = code table date, aux = codes added
+static const uint32_t kSysEventQuoteUnit = 5;   // MSG_SYS_QUOTEUNIT_CHANGE: wind_code / symbol_id
+
+struct SystemEvent {
+  uint32_t type;            // kSysEvent*
+  int32_t  code;            // kSysEventMarket: TDF MARKET_EVENT_NUM (open / clear / close / heartbeat ...)
+  char     market[8];       // same key as MarketStatus::market
+  int32_t  date;            // yyyymmdd (0 if the event carries none)
+  int32_t  aux;             // per type, see kSysEvent*; code count for partial code clears
+  uint32_t market_id;       // header.markets index, kInvalidSymbolId if the status block is full
+  uint32_t symbol_id;       // symbol of wind_code in the snapshot table, kInvalidSymbolId if none
+  char     wind_code[16];   // first code the event names ('\0' if none)
+  uint64_t recv_ns;         // gateway monotonic ns
+};
+
+struct alignas(kCacheLineBytes) SystemEventSlot {
+  AtomicU64 seq;
+  SystemEvent rec;
+};
+
+static_assert(sizeof(SystemEvent) == 56, "SystemEvent size mismatch");
+static_assert(sizeof(SystemEventSlot) == kCacheLineBytes, "SystemEventSlot must be one cacheline");
+
+// -------------------------
+// Limit-up state (per symbol, from snapshots)
+// -------------------------
+//
+// The limit-up lifecycle of the day, kept by the gateway from every snapshot (LimitUpTracker):
+// - touched: high reached high_limit_x10000
+// - sealed: best bid at the limit with the ask side empty
+// - broken: sealed before, not sealed now (every sealed -> not sealed transition counts as a break)
+// At the close, state == kLimitUpSealed is the "sealed" flag and breaks != 0 the "broke" flag of the
+// offline universe files. Times are snapshot nTime (HHMMSSmmm), 0 = not happened.
+
+// LimitUpState::state
+static const uint32_t kLimitUpNone = 0;     // limit not reached today
+static const uint32_t kLimitUpTouched = 1;  // reached, never sealed
+static const uint32_t kLimitUpSealed = 2;
+static const uint32_t kLimitUpBroken = 3;   // was sealed, not sealed now
+
+struct LimitUpState {
+  uint32_t state;             // kLimitUp*
+  uint32_t breaks;
+  int32_t  first_touch_time;
+  int32_t  seal_time;         // first seal
+  int32_t  break_time;        // last break
+  int32_t  reseal_time;       // last re-seal after a break
+  int64_t  limit_x10000;      // high limit the state refers to
+  int64_t  seal_volume;       // bid_vol[0] while sealed, 0 otherwise
+  int64_t  peak_seal_volume;
+  uint64_t last_update_ns;    // gateway monotonic ns, 0 = never published
+};
+
+struct alignas(kCacheLineBytes) LimitUpEntry {
+  AtomicU32 seq;              // seqlock counter
+  uint32_t _pad0;
+  LimitUpState v;
+};
+
+static_assert(sizeof(LimitUpEntry) == kCacheLineBytes, "LimitUpEntry must be one cacheline");
+
+// -------------------------
+// Seal erosion (limit-up symbols)
+// -------------------------
+//
+// How fast the seal queue at the limit shrinks, over kSealWindows rolling horizons of exchange time
+// (SealErosionTracker). Seal volume comes from snapshots (LimitUpState::seal_volume, 0 when not
+// sealed); with tick streams the volume executed and the bid volume cancelled at the limit are added
+// per horizon (1s granularity). Amounts are yuan: volume x limit price.
+
+static const uint32_t kSealWindows = 3;
+static const int32_t kSealWindowMs[kSealWindows] = {3000, 30000, 60000};
+
+// SealErosion::flags
+static const uint32_t kSealErosionSealed = 1u << 0;   // sealed at the last snapshot
+static const uint32_t kSealErosionTrades = 1u << 1;   // traded[] is fed (TRANSACTION subscribed)
+static const uint32_t kSealErosionCancels = 1u << 2;  // cancelled[] is fed: SH with orders, SZ stocks with --l3-book
+
+struct SealWindow {
+  int64_t volume_delta;     // seal volume now minus at the start of the horizon (negative = eroding)
+  int64_t amount_delta;
+  int64_t traded;           // volume executed at the limit inside the horizon
+  int64_t cancelled;        // bid volume cancelled at the limit inside the horizon
+};
+
+struct SealErosion {
+  int32_t  time_hhmmssmmm;  // last snapshot or tick folded in, 0 = never published
+  uint32_t flags;           // kSealErosion*
+  int64_t  seal_volume;
+  int64_t  seal_amount;
+  SealWindow w[kSealWindows];  // kSealWindowMs order
+};
+
+struct alignas(kCacheLineBytes) SealErosionEntry {
+  AtomicU32 seq;            // seqlock counter
+  uint32_t _pad0;
+  SealErosion v;
+};
+
+static_assert(sizeof(SealErosionEntry) == 2 * kCacheLineBytes, "SealErosionEntry size mismatch");
+
+// Index wind codes are not restricted to 6-digit SH/SZ: accepts 1-10 alphanumerics, '.', then a
+// 2-4 letter market (e.g. "000300.SH", "399006.SZ", "H30269.CSI"). out_wind16 receives the
+// upper-case code, '\0'-padded.
+inline bool parse_index_code(const char* wind_code, char* out_wind16) {
+  if (!wind_code || !out_wind16) return false;
+  char canon[kWindCodeBytes];
+  ::memset(canon, 0, sizeof(canon));
+  uint32_t i = 0;
+  for (; wind_code[i] != '.'; ++i) {
+    const char c = wind_code[i];
+    const bool alnum = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+    if (!alnum || i >= 10) return false;
+    canon[i] = (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+  }
+  if (i == 0) return false;
+  canon[i++] = '.';
+  const uint32_t market_begin = i;
+  for (; wind_code[i] != '\0'; ++i) {
+    const char c = wind_code[i];
+    const bool alpha = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+    if (!alpha || i - market_begin >= 4) return false;
+    canon[i] = (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+  }
+  if (i - market_begin < 2) return false;
+  ::memcpy(out_wind16, canon, kWindCodeBytes);
+  return true;
+}
+
+// Linear scan of the index directory (a few dozen entries); kInvalidSymbolId if absent.
+inline uint32_t index_dir_find(const char* dir, uint32_t count, const char* canon16) {
+  for (uint32_t i = 0; i < count; ++i) {
+    if (::memcmp(dir + static_cast<size_t>(i) * kWindCodeBytes, canon16, kWindCodeBytes) == 0) return i;
+  }
+  return kInvalidSymbolId;
+}
+
+// -------------------------
+// Feed integrity stats
+// -------------------------
+//
+// One slot per sequenced feed stream, written by the gateway's gap tracker (FeedGapTracker):
+// - kFeedStreamTdfMsg: TDF_MSG::nOrder of every message on the connection
+// - kFeedStreamBizIndex: nBizIndex per (market, channel), trades and orders merged (SH merged feed)
+// - kFeedStreamSzApplSeq: SZ nIndex / nOrder per channel (trades and orders share ApplSeqNum)
+// - kFeedStreamShTrade / kFeedStreamShOrder: SH nIndex / nOrder per channel when nBizIndex is absent
+// A hole is only declared a gap once the stream has moved kFeedGapWindow past it, so records that
+// arrive out of order across messages (orders vs trades of one channel) are not counted.
+
+static const uint32_t kFeedStreamTdfMsg = 0;
+static const uint32_t kFeedStreamBizIndex = 1;
+static const uint32_t kFeedStreamSzApplSeq = 2;
+static const uint32_t kFeedStreamShTrade = 3;
+static const uint32_t kFeedStreamShOrder = 4;
+static const uint32_t kFeedGapWindow = 1024;       // reorder tolerance, sequence numbers
+
+// stream_key = market(1=SH,0=SZ) << 28 | kind << 24 | channel (24 bits)
+inline uint32_t feed_stream_key(uint32_t market, uint32_t kind, uint32_t channel) {
+  return (market << 28) | ((kind & 0xFu) << 24) | (channel & 0xFFFFFFu);
+}
+
+struct alignas(kCacheLineBytes) FeedStreamStats {
+  uint32_t  stream_key;     // feed_stream_key(); written before feed_stats_count covers the slot
+  uint32_t  _pad0;
+  AtomicU64 last_seq;       // highest sequence number seen
+  AtomicU64 received;
+  AtomicU64 gaps;           // holes given up
+  AtomicU64 gap_seqs;       // sequence numbers never received
+  AtomicU64 max_gap;        // largest single hole
+  AtomicU64 late;           // duplicates and arrivals after their hole was given up
+  AtomicU64 last_gap_ns;    // gateway monotonic ns of the last gap
+};
+
+static_assert(sizeof(FeedStreamStats) == kCacheLineBytes, "FeedStreamStats must be one cacheline");
+
 // -------------------------
 // SeqLock helpers
 // -------------------------
@@ -238,6 +1159,9 @@ static_assert(sizeof(SnapshotEntry) == (kCacheLineBytes + kMarketDataBytes), "Sn
 //     s2 = load(seq) [acquire]
 //     if s1 == s2 -> success else retry
 
+// Odd, so it can never be mistaken for a stable seq; used to mark failed reads in batch APIs.
+static const uint32_t kSeqInvalid = 0xFFFFFFFFu;
+
 inline uint32_t seqlock_write_begin(AtomicU32* seq) {
   // Make it odd.
   uint32_t odd = fetch_add_u32_relaxed(seq, 1) + 1;
@@ -266,6 +1190,14 @@ inline bool seqlock_read_once(const SnapshotEntry* e, MarketData320* out, uint32
   return true;
 }
 
+// Prefetch the meta cacheline and the whole payload of one entry.
+inline void prefetch_snapshot_entry(const SnapshotEntry* e) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(e);
+  for (uint32_t off = 0; off < sizeof(SnapshotEntry); off += kCacheLineBytes) {
+    prefetch_ro(p + off);
+  }
+}
+
 // -------------------------
 // Layout helpers
 // -------------------------
@@ -282,4 +1214,94 @@ inline const SnapshotEntry* snapshot_table(const void* shm_base, const ShmHeader
   return reinterpret_cast<const SnapshotEntry*>(reinterpret_cast<const uint8_t*>(shm_base) + h->snapshot_offset);
 }
 
+inline const SymbolIndexSlot* symbol_index(const void* shm_base, const ShmHeader* h) {
+  if (h->symbol_index_offset == 0) return nullptr;
+  return reinterpret_cast<const SymbolIndexSlot*>(reinterpret_cast<const uint8_t*>(shm_base) +
+                                                  h->symbol_index_offset);
+}
+
+inline ReaderSlot* reader_registry(void* shm_base, const ShmHeader* h) {
+  if (h->reader_registry_offset == 0) return nullptr;
+  return reinterpret_cast<ReaderSlot*>(reinterpret_cast<uint8_t*>(shm_base) + h->reader_registry_offset);
+}
+
+inline const TransactionSlot* transaction_ring(const void* shm_base, const ShmHeader* h) {
+  if (h->event_ring_offset == 0 || (h->flags & kShmFlagTransactionRing) == 0) return nullptr;
+  return reinterpret_cast<const TransactionSlot*>(reinterpret_cast<const uint8_t*>(shm_base) +
+                                                  h->event_ring_offset);
+}
+
+inline const OrderSlot* order_ring(const void* shm_base, const ShmHeader* h) {
+  if (h->order_ring_offset == 0 || (h->flags & kShmFlagOrderRing) == 0) return nullptr;
+  return reinterpret_cast<const OrderSlot*>(reinterpret_cast<const uint8_t*>(shm_base) + h->order_ring_offset);
+}
+
+inline const OrderQueueEntry* order_queue_table(const void* shm_base, const ShmHeader* h) {
+  if (h->order_queue_offset == 0 || (h->flags & kShmFlagOrderQueue) == 0) return nullptr;
+  return reinterpret_cast<const OrderQueueEntry*>(reinterpret_cast<const uint8_t*>(shm_base) +
+                                                  h->order_queue_offset);
+}
+
+inline const char* index_dir(const void* shm_base, const ShmHeader* h) {
+  if (h->index_dir_offset == 0 || (h->flags & kShmFlagIndexTable) == 0) return nullptr;
+  return reinterpret_cast<const char*>(shm_base) + h->index_dir_offset;
+}
+
+inline const IndexEntry* index_entries(const void* shm_base, const ShmHeader* h) {
+  if (h->index_entries_offset == 0 || (h->flags & kShmFlagIndexTable) == 0) return nullptr;
+  return reinterpret_cast<const IndexEntry*>(reinterpret_cast<const uint8_t*>(shm_base) + h->index_entries_offset);
+}
+
+inline const L3BookEntry* l3_book_table(const void* shm_base, const ShmHeader* h) {
+  if (h->l3_book_offset == 0 || (h->flags & kShmFlagL3Book) == 0) return nullptr;
+  return reinterpret_cast<const L3BookEntry*>(reinterpret_cast<const uint8_t*>(shm_base) + h->l3_book_offset);
+}
+
+inline const LiveTradeEntry* live_trade_table(const void* shm_base, const ShmHeader* h) {
+  if (h->live_trade_offset == 0 || (h->flags & kShmFlagLiveTrade) == 0) return nullptr;
+  return reinterpret_cast<const LiveTradeEntry*>(reinterpret_cast<const uint8_t*>(shm_base) +
+                                                 h->live_trade_offset);
+}
+
+// Head of symbol_id's history ring; its slots follow it (history_slots()).
+inline const HistoryHead* history_head(const void* shm_base, const ShmHeader* h, uint32_t symbol_id) {
+  if (h->history_offset == 0 || (h->flags & kShmFlagHistory) == 0) return nullptr;
+  return reinterpret_cast<const HistoryHead*>(reinterpret_cast<const uint8_t*>(shm_base) + h->history_offset +
+                                              static_cast<uint64_t>(symbol_id) * h->history_stride_bytes);
+}
+
+inline const HistorySlot* history_slots(const HistoryHead* head) {
+  return reinterpret_cast<const HistorySlot*>(head + 1);
+}
+
+inline const LimitUpEntry* limit_up_table(const void* shm_base, const ShmHeader* h) {
+  if (h->limit_up_offset == 0 || (h->flags & kShmFlagLimitUp) == 0) return nullptr;
+  return reinterpret_cast<const LimitUpEntry*>(reinterpret_cast<const uint8_t*>(shm_base) + h->limit_up_offset);
+}
+
+inline const SealErosionEntry* seal_erosion_table(const void* shm_base, const ShmHeader* h) {
+  if (h->seal_erosion_offset == 0 || (h->flags & kShmFlagSealErosion) == 0) return nullptr;
+  return reinterpret_cast<const SealErosionEntry*>(reinterpret_cast<const uint8_t*>(shm_base) +
+                                                   h->seal_erosion_offset);
+}
+
+inline const SystemEventSlot* sys_event_ring(const void* shm_base, const ShmHeader* h) {
+  if (h->sys_event_offset == 0 || (h->flags & kShmFlagSystemEvents) == 0) return nullptr;
+  return reinterpret_cast<const SystemEventSlot*>(reinterpret_cast<const uint8_t*>(shm_base) +
+                                                  h->sys_event_offset);
+}
+
+inline const FeedStreamStats* feed_stats(const void* shm_base, const ShmHeader* h) {
+  if (h->feed_stats_offset == 0 || (h->flags & kShmFlagFeedIntegrity) == 0) return nullptr;
+  return reinterpret_cast<const FeedStreamStats*>(reinterpret_cast<const uint8_t*>(shm_base) +
+                                                  h->feed_stats_offset);
+}
+
+inline const SnapshotEntry* mirror_entries(const void* shm_base, const ShmHeader* h, uint32_t mirror) {
+  if (h->mirror_entries_offset == 0 || mirror >= h->mirror_capacity) return nullptr;
+  return reinterpret_cast<const SnapshotEntry*>(reinterpret_cast<const uint8_t*>(shm_base) +
+                                                h->mirror_entries_offset) +
+         static_cast<size_t>(mirror) * h->mirror_max_symbols;
+}
+
 } // namespace mdg